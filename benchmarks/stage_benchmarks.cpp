@@ -0,0 +1,220 @@
+#include <glad/glad.h>  // OpenGL loader
+#include <GLFW/glfw3.h> // Hidden window for the upload stage
+#include <benchmark/benchmark.h>
+
+#include "building_mesh.h"
+#include "building_set.h"
+#include "city.h"
+#include "geometry_builder.h"
+#include "gl_extensions.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+// Every heap allocation in the process, so each stage can report allocations per building
+static std::atomic<size_t> allocationCount(0);
+
+void* operator new(std::size_t size) {
+    allocationCount++;
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+// Every delete form frees what the counting operator new allocated
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+// Shared by every benchmark, set up in main()
+static ThreadPool* workers = nullptr;
+static bool haveContext = false;
+
+// Throughput and allocation counters common to every stage
+static void reportStage(benchmark::State& state, size_t buildings, size_t allocations, size_t bytesPerBuilding) {
+    double processed = (double)buildings * state.iterations();
+    state.counters["buildings/s"] = benchmark::Counter(processed, benchmark::Counter::kIsRate);
+    state.counters["allocs/building"] = processed > 0.0 ? allocations / processed : 0.0;
+    state.SetBytesProcessed((int64_t)(processed * bytesPerBuilding));
+}
+
+// Same city for every stage of a given size
+static void generateInput(size_t count, std::vector<Building>& buildings) {
+    buildings.clear();
+    generateCity(buildings, (int)count, 1, workers);
+}
+
+// generateCity(), serial (arg 1 = 0) or on the pool
+static void generateCityStage(benchmark::State& state) {
+    size_t count = (size_t)state.range(0);
+    ThreadPool* pool = state.range(1) ? workers : nullptr;
+    size_t allocations = 0;
+    for (auto _ : state) {
+        std::vector<Building> buildings;
+        size_t before = allocationCount;
+        generateCity(buildings, (int)count, 1, pool);
+        allocations += allocationCount - before;
+        benchmark::DoNotOptimize(buildings.data());
+    }
+    reportStage(state, count, allocations, sizeof(Building));
+}
+BENCHMARK(generateCityStage)->ArgNames({ "buildings", "pool" })
+    ->ArgsProduct({ benchmark::CreateRange(1000, 10000000, 10), { 0, 1 } })->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// The original AoS createBuildingBuffers(), 8 vertices and 36 indices per box
+static void createBuildingBuffersStage(benchmark::State& state) {
+    size_t count = (size_t)state.range(0);
+    std::vector<Building> buildings;
+    generateInput(count, buildings);
+    size_t allocations = 0;
+    for (auto _ : state) {
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        size_t before = allocationCount;
+        createBuildingBuffers(buildings, vertices, indices);
+        allocations += allocationCount - before;
+        benchmark::DoNotOptimize(vertices.data());
+        benchmark::DoNotOptimize(indices.data());
+    }
+    reportStage(state, buildings.size(), allocations, 48 * sizeof(float) + 36 * sizeof(unsigned int));
+}
+BENCHMARK(createBuildingBuffersStage)->ArgName("buildings")->RangeMultiplier(10)->Range(1000, 10000000)
+    ->Unit(benchmark::kMillisecond);
+
+// SoA SIMD kernel into exactly sized vectors, serial or on the pool
+static void buildingSetStage(benchmark::State& state) {
+    size_t count = (size_t)state.range(0);
+    ThreadPool* pool = state.range(1) ? workers : nullptr;
+    std::vector<Building> buildings;
+    generateInput(count, buildings);
+    BuildingSet set;
+    toBuildingSet(buildings, set);
+    size_t allocations = 0;
+    for (auto _ : state) {
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        size_t before = allocationCount;
+        createBuildingBuffers(set, vertices, indices, pool);
+        allocations += allocationCount - before;
+        benchmark::DoNotOptimize(vertices.data());
+        benchmark::DoNotOptimize(indices.data());
+    }
+    state.SetLabel(buildingKernelName());
+    reportStage(state, buildings.size(), allocations, 48 * sizeof(float) + 36 * sizeof(unsigned int));
+}
+BENCHMARK(buildingSetStage)->ArgNames({ "buildings", "pool" })
+    ->ArgsProduct({ benchmark::CreateRange(1000, 10000000, 10), { 0, 1 } })->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Block-wise baking into one preallocated buffer (the mapped-buffer path), float or packed
+static void bakeVerticesStage(benchmark::State& state) {
+    size_t count = (size_t)state.range(0);
+    bool packed = state.range(1) != 0;
+    std::vector<Building> buildings;
+    generateInput(count, buildings);
+    glm::vec3 boundsMin, boundsMax;
+    buildingVertexBounds(buildings.data(), buildings.size(), boundsMin, boundsMax);
+    GeometrySizes sizes = buildingGeometrySizes(buildings.size(), packed);
+    std::vector<unsigned char> out(sizes.vertexBytes);
+    GeometryBuilder builder;
+    size_t allocations = 0;
+    for (auto _ : state) {
+        size_t before = allocationCount;
+        bakeBuildingVertices(builder, buildings.data(), buildings.size(), packed, boundsMin, boundsMax - boundsMin,
+                             out.data(), workers);
+        allocations += allocationCount - before;
+        benchmark::DoNotOptimize(out.data());
+    }
+    reportStage(state, buildings.size(), allocations, sizes.vertexBytes / buildings.size());
+}
+BENCHMARK(bakeVerticesStage)->ArgNames({ "buildings", "packed" })
+    ->ArgsProduct({ benchmark::CreateRange(1000, 10000000, 10), { 0, 1 } })->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// createBuildingMesh() baking straight into a mapped buffer, timed up to glFinish()
+static void uploadStage(benchmark::State& state) {
+    if (!haveContext) {
+        state.SkipWithError("no GL context");
+        return;
+    }
+    size_t count = (size_t)state.range(0);
+    bool packed = state.range(1) != 0;
+    std::vector<Building> buildings;
+    generateInput(count, buildings);
+    size_t allocations = 0;
+    for (auto _ : state) {
+        size_t before = allocationCount;
+        BuildingMesh mesh = createBuildingMesh(buildings, packed, nullptr, workers);
+        glFinish();
+        allocations += allocationCount - before;
+
+        state.PauseTiming();
+        destroyBuildingMesh(mesh);
+        glFinish();
+        state.ResumeTiming();
+    }
+    GeometrySizes sizes = buildingGeometrySizes(buildings.size(), packed);
+    reportStage(state, buildings.size(), allocations, sizes.vertexBytes / buildings.size());
+}
+BENCHMARK(uploadStage)->ArgNames({ "buildings", "packed" })
+    ->ArgsProduct({ benchmark::CreateRange(1000, 10000000, 10), { 0, 1 } })->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Hidden 3.3 core window whose context the upload stage draws into
+static GLFWwindow* createContext() {
+    if (!glfwInit())
+        return nullptr;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "City Benchmarks", NULL, NULL);
+    if (!window)
+        return nullptr;
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+        return nullptr;
+    loadGLExtensions();
+    return window;
+}
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    ThreadPool pool(0);
+    workers = &pool;
+
+    // CPU stages still run without a display, the upload stage is skipped
+    haveContext = createContext() != nullptr;
+    if (!haveContext)
+        std::cerr << "ERROR::BENCHMARK::NO_CONTEXT upload stage skipped" << std::endl;
+
+    benchmark::RunSpecifiedBenchmarks();
+    glfwTerminate();
+    return 0;
+}
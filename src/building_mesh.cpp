@@ -0,0 +1,294 @@
+#include "building_mesh.h"
+#include "building_set.h"
+#include "geometry_builder.h"
+#include "instancing.h"
+#include "uniform_buffers.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+// Allocate and fill the buffer bound to target, directly or through the ring
+static void uploadBufferData(GLenum target, unsigned int buffer, const void* data, size_t bytes, StreamBuffer* stream) {
+    if (stream) {
+        glBufferData(target, bytes, NULL, GL_STATIC_DRAW);
+        streamUpload(*stream, buffer, 0, data, bytes);
+    } else {
+        glBufferData(target, bytes, data, GL_STATIC_DRAW);
+    }
+}
+
+static unsigned short quantize(float value, float origin, float scale) {
+    float t = (value - origin) / scale;
+    t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    return (unsigned short)(t * 65535.0f + 0.5f);
+}
+
+static unsigned char unorm8(float value) {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (unsigned char)(value * 255.0f + 0.5f);
+}
+
+void packBuildingVertices(const float* vertices, size_t vertexCount, const glm::vec3& origin,
+                          const glm::vec3& scale, PackedBuildingVertex* out) {
+    for (size_t i = 0; i < vertexCount; i++) {
+        const float* v = vertices + i * 6;
+        PackedBuildingVertex& p = out[i];
+        p.position[0] = quantize(v[0], origin.x, scale.x);
+        p.position[1] = quantize(v[1], origin.y, scale.y);
+        p.position[2] = quantize(v[2], origin.z, scale.z);
+        p.padding = 0;
+
+        // Top corners carry the CPU brightening, take the base color from the matching bottom corner
+        bool top = (i & 7) >= 4;
+        const float* base = top ? v - 4 * 6 : v;
+        p.color[0] = unorm8(base[3]);
+        p.color[1] = unorm8(base[4]);
+        p.color[2] = unorm8(base[5]);
+        p.color[3] = top ? 255 : 0;
+    }
+}
+
+void createChunkIndices(unsigned int buildings, std::vector<unsigned short>& indices) {
+    std::vector<unsigned int> cubeIndices;
+    createSurfaceCubeIndices(cubeIndices);
+
+    indices.resize((size_t)buildings * cubeIndices.size());
+    for (unsigned int b = 0; b < buildings; b++) {
+        for (size_t i = 0; i < cubeIndices.size(); i++)
+            indices[b * cubeIndices.size() + i] = (unsigned short)(b * 8 + cubeIndices[i]);
+    }
+}
+
+void measureChunkIndices(unsigned int cacheSize, VertexCacheStats& handWritten, VertexCacheStats& optimized) {
+    std::vector<float> cubeVertices;
+    std::vector<unsigned int> cubeIndices;
+    createUnitCube(cubeVertices, cubeIndices);
+    cubeIndices.erase(cubeIndices.begin(), cubeIndices.end() - SURFACE_CUBE_INDICES);
+
+    std::vector<unsigned int> indices((size_t)MESH_CHUNK_BUILDINGS * SURFACE_CUBE_INDICES);
+    for (unsigned int b = 0; b < MESH_CHUNK_BUILDINGS; b++) {
+        for (unsigned int i = 0; i < SURFACE_CUBE_INDICES; i++)
+            indices[b * SURFACE_CUBE_INDICES + i] = b * 8 + cubeIndices[i];
+    }
+    handWritten = analyzeVertexCache(indices.data(), indices.size(), MESH_CHUNK_VERTICES, cacheSize);
+
+    std::vector<unsigned short> chunk;
+    createChunkIndices(MESH_CHUNK_BUILDINGS, chunk);
+    indices.assign(chunk.begin(), chunk.end());
+    optimized = analyzeVertexCache(indices.data(), indices.size(), MESH_CHUNK_VERTICES, cacheSize);
+}
+
+// Create the GL objects and leave the VAO and VBO bound for the vertex upload
+static void createMeshObjects(BuildingMesh& mesh) {
+    glGenVertexArrays(1, &mesh.VAO);
+    glGenBuffers(1, &mesh.VBO);
+    glGenBuffers(1, &mesh.EBO);
+
+    glBindVertexArray(mesh.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+}
+
+// Point attributes 0 and 1 of the bound VAO at the bound vertex buffer
+static void describeVertexLayout(const BuildingMesh& mesh) {
+    if (mesh.packed) {
+        // Normalized position and color, top flag in alpha
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedBuildingVertex),
+                              (void*)offsetof(PackedBuildingVertex, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedBuildingVertex),
+                              (void*)offsetof(PackedBuildingVertex, color));
+        glEnableVertexAttribArray(1);
+    } else {
+        // Position attribute
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        // Color attribute
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+    }
+}
+
+// One chunk's worth of indices into the bound element buffer, shared by every chunk
+static void uploadChunkIndices(const BuildingMesh& mesh, StreamBuffer* stream) {
+    std::vector<unsigned short> indices;
+    createChunkIndices(std::min(mesh.buildingCount, MESH_CHUNK_BUILDINGS), indices);
+    uploadBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO, indices.data(), indices.size() * sizeof(unsigned short), stream);
+}
+
+// Upload the shared chunk indices and describe the vertex layout
+static void finishMeshObjects(BuildingMesh& mesh, StreamBuffer* stream) {
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+    uploadChunkIndices(mesh, stream);
+    describeVertexLayout(mesh);
+
+    glBindVertexArray(0);
+}
+
+static void setQuantization(BuildingMesh& mesh, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    mesh.quantOrigin = boundsMin;
+    mesh.quantScale = glm::max(boundsMax - boundsMin, glm::vec3(1e-3f));
+    mesh.transformSlot = allocateMeshTransform(mesh.quantOrigin, mesh.quantScale);
+}
+
+BuildingMesh createBuildingMesh(const std::vector<Building>& buildings, bool packed, StreamBuffer* stream,
+                                ThreadPool* pool) {
+    BuildingMesh mesh = BuildingMesh();
+    mesh.buildingCount = buildings.size();
+    mesh.packed = packed;
+    if (packed) {
+        glm::vec3 boundsMin, boundsMax;
+        buildingVertexBounds(buildings.data(), buildings.size(), boundsMin, boundsMax);
+        setQuantization(mesh, boundsMin, boundsMax);
+    }
+
+    createMeshObjects(mesh);
+
+    // Exact size up front, then bake block by block with the SIMD kernel
+    GeometrySizes sizes = buildingGeometrySizes(buildings.size(), packed);
+    GeometryBuilder builder;
+    bool baked = false;
+    if (!stream && sizes.vertexBytes) {
+        // Straight into the driver's memory, no CPU copy of the whole mesh
+        glBufferData(GL_ARRAY_BUFFER, sizes.vertexBytes, NULL, GL_STATIC_DRAW);
+        void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, sizes.vertexBytes,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped) {
+            bakeBuildingVertices(builder, buildings.data(), buildings.size(), packed,
+                                 mesh.quantOrigin, mesh.quantScale, mapped, pool);
+            baked = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE; // false: contents lost, bake again below
+        }
+    }
+    if (!baked) {
+        // Streamed chunks are small, stage them and copy through the ring
+        std::vector<unsigned char> vertices(sizes.vertexBytes);
+        bakeBuildingVertices(builder, buildings.data(), buildings.size(), packed,
+                             mesh.quantOrigin, mesh.quantScale, vertices.data(), pool);
+        uploadBufferData(GL_ARRAY_BUFFER, mesh.VBO, vertices.data(), vertices.size(), stream);
+    }
+
+    finishMeshObjects(mesh, stream);
+    return mesh;
+}
+
+BuildingMesh createBuildingMesh(const float* vertices, size_t vertexFloats, bool packed, StreamBuffer* stream) {
+    BuildingMesh mesh = BuildingMesh();
+    mesh.buildingCount = vertexFloats / 48;
+    mesh.packed = packed;
+
+    createMeshObjects(mesh);
+    if (packed) {
+        // Quantize into the bounds of this mesh
+        size_t vertexCount = vertexFloats / 6;
+        glm::vec3 boundsMin(0.0f), boundsMax(0.0f);
+        for (size_t i = 0; i < vertexCount; i++) {
+            glm::vec3 p(vertices[i * 6], vertices[i * 6 + 1], vertices[i * 6 + 2]);
+            boundsMin = i ? glm::min(boundsMin, p) : p;
+            boundsMax = i ? glm::max(boundsMax, p) : p;
+        }
+        setQuantization(mesh, boundsMin, boundsMax);
+
+        std::vector<PackedBuildingVertex> packedVertices(vertexCount);
+        packBuildingVertices(vertices, vertexCount, mesh.quantOrigin, mesh.quantScale, packedVertices.data());
+        uploadBufferData(GL_ARRAY_BUFFER, mesh.VBO, packedVertices.data(),
+                         vertexCount * sizeof(PackedBuildingVertex), stream);
+    } else {
+        uploadBufferData(GL_ARRAY_BUFFER, mesh.VBO, vertices, vertexFloats * sizeof(float), stream);
+    }
+
+    finishMeshObjects(mesh, stream);
+    return mesh;
+}
+
+void updateBuildingMesh(BuildingMesh& mesh, StreamBuffer& stream, unsigned int first,
+                        const Building* buildings, unsigned int count) {
+    // Packed edits keep the mesh's quantization bounds, anything moved outside is clamped to them
+    GeometrySizes sizes = buildingGeometrySizes(count, mesh.packed);
+    std::vector<unsigned char> vertices(sizes.vertexBytes);
+    GeometryBuilder builder;
+    bakeBuildingVertices(builder, buildings, count, mesh.packed, mesh.quantOrigin, mesh.quantScale, vertices.data(),
+                         nullptr);
+
+    size_t vertexSize = mesh.packed ? sizeof(PackedBuildingVertex) : 6 * sizeof(float);
+    streamUpload(stream, mesh.VBO, (size_t)first * 8 * vertexSize, vertices.data(), vertices.size());
+}
+
+void resizeBuildingMesh(BuildingMesh& mesh, unsigned int buildingCount) {
+    size_t vertexSize = mesh.packed ? sizeof(PackedBuildingVertex) : 6 * sizeof(float);
+    size_t kept = (size_t)std::min(mesh.buildingCount, buildingCount) * 8 * vertexSize;
+
+    // Copy GPU to GPU, the CPU never sees the existing vertices
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, (size_t)buildingCount * 8 * vertexSize, NULL, GL_STATIC_DRAW);
+    if (kept) {
+        glBindBuffer(GL_COPY_READ_BUFFER, mesh.VBO);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, kept);
+    }
+    glDeleteBuffers(1, &mesh.VBO);
+    mesh.VBO = buffer;
+
+    bool moreIndices = std::min(buildingCount, MESH_CHUNK_BUILDINGS) > std::min(mesh.buildingCount, MESH_CHUNK_BUILDINGS);
+    mesh.buildingCount = buildingCount;
+
+    glBindVertexArray(mesh.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    describeVertexLayout(mesh);
+    if (moreIndices) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+        uploadChunkIndices(mesh, nullptr);
+    }
+    glBindVertexArray(0);
+}
+
+void bindBuildingMeshUniforms(const BuildingMesh& mesh) {
+    if (mesh.packed)
+        bindMeshTransform(mesh.transformSlot);
+}
+
+void drawBuildingMesh(const BuildingMesh& mesh) {
+    std::vector<DrawRange> ranges(1);
+    ranges[0].first = 0;
+    ranges[0].count = mesh.buildingCount;
+    drawBuildingMeshRanges(mesh, ranges);
+}
+
+void drawBuildingMeshRanges(const BuildingMesh& mesh, const std::vector<DrawRange>& ranges) {
+    if (ranges.empty())
+        return;
+
+    // Each building owns SURFACE_CUBE_INDICES indices, split ranges where they cross into the next chunk
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices;
+    counts.reserve(ranges.size());
+    offsets.reserve(ranges.size());
+    baseVertices.reserve(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++) {
+        unsigned int first = ranges[i].first;
+        unsigned int remaining = ranges[i].count;
+        while (remaining) {
+            unsigned int local = first % MESH_CHUNK_BUILDINGS;
+            unsigned int count = std::min(remaining, MESH_CHUNK_BUILDINGS - local);
+            counts.push_back(count * SURFACE_CUBE_INDICES);
+            offsets.push_back((const void*)(local * SURFACE_CUBE_INDICES * sizeof(unsigned short)));
+            baseVertices.push_back((first / MESH_CHUNK_BUILDINGS) * MESH_CHUNK_VERTICES);
+            first += count;
+            remaining -= count;
+        }
+    }
+
+    bindBuildingMeshUniforms(mesh);
+    glBindVertexArray(mesh.VAO);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_SHORT, offsets.data(), counts.size(),
+                                  baseVertices.data());
+}
+
+void destroyBuildingMesh(BuildingMesh& mesh) {
+    if (mesh.packed)
+        releaseMeshTransform(mesh.transformSlot);
+    glDeleteVertexArrays(1, &mesh.VAO);
+    glDeleteBuffers(1, &mesh.VBO);
+    glDeleteBuffers(1, &mesh.EBO);
+}
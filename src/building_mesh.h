@@ -0,0 +1,88 @@
+#ifndef BUILDING_MESH_H
+#define BUILDING_MESH_H
+
+#include "city.h"
+#include "spatial_grid.h"
+#include "stream_buffer.h"
+#include "vertex_cache.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Compact vertex, 12 bytes instead of 24. Positions are 16-bit normalized
+// offsets inside the mesh bounds, color is the building's base color and
+// alpha flags top corners, which packedVertexShaderSource brightens by 0.1.
+struct PackedBuildingVertex {
+    unsigned short position[3];
+    unsigned short padding;
+    unsigned char color[4];
+};
+
+// Buildings per index chunk: 8 vertices each makes 65536, the most a 16-bit index reaches
+static const unsigned int MESH_CHUNK_BUILDINGS = 8192;
+static const unsigned int MESH_CHUNK_VERTICES = MESH_CHUNK_BUILDINGS * 8;
+
+// GPU objects for the pre-baked building path (8 vertices / 30 drawn indices per box).
+// Every building's indices are the same pattern offset by 8 vertices, so the mesh
+// is split into chunks of MESH_CHUNK_BUILDINGS and one 16-bit index buffer for a
+// single chunk serves all of them through glDrawElementsBaseVertex.
+struct BuildingMesh {
+    unsigned int VAO;
+    unsigned int VBO;
+    unsigned int EBO;
+    unsigned int buildingCount;
+    bool packed;
+    glm::vec3 quantOrigin; // packed only: position = quantOrigin + normalized * quantScale
+    glm::vec3 quantScale;
+    unsigned int transformSlot; // packed only: the quantization in the shared MeshTransform buffer
+};
+
+// Bake buildings with the SoA mesh kernel and upload them, staged through
+// stream when one is given so streamed chunks don't stall on glBufferData.
+// pool, when given, bakes into the mapped buffer from every thread; only the
+// calling thread touches GL.
+BuildingMesh createBuildingMesh(const std::vector<Building>& buildings, bool packed, StreamBuffer* stream,
+                                ThreadPool* pool);
+
+// Upload already baked interleaved vertices (6 floats, 8 per building), as they are
+// or quantized to PackedBuildingVertex. The 32-bit indices baked alongside them
+// aren't needed, the mesh builds its own 16-bit chunk index buffer. Null float
+// vertices only allocate vertexFloats.
+BuildingMesh createBuildingMesh(const float* vertices, size_t vertexFloats, bool packed, StreamBuffer* stream);
+
+// 16-bit indices of one chunk (buildings * SURFACE_CUBE_INDICES, no bottom faces),
+// chunk-relative vertex numbers
+void createChunkIndices(unsigned int buildings, std::vector<unsigned short>& indices);
+
+// Post-transform cache behaviour of one chunk's indices under a FIFO of cacheSize,
+// for the hand-written face order and for the optimized order actually drawn
+void measureChunkIndices(unsigned int cacheSize, VertexCacheStats& handWritten, VertexCacheStats& optimized);
+
+// Quantize baked vertices (8 per building, top corners last) into the given bounds
+void packBuildingVertices(const float* vertices, size_t vertexCount, const glm::vec3& origin,
+                          const glm::vec3& scale, PackedBuildingVertex* out);
+
+// Bind the MeshTransform slot of a packed mesh, for callers drawing its VAO directly
+void bindBuildingMeshUniforms(const BuildingMesh& mesh);
+
+// Rewrite buildings [first, first + count) in place through the ring. Indices only
+// depend on a building's slot, so just the vertex bytes of the range are patched.
+void updateBuildingMesh(BuildingMesh& mesh, StreamBuffer& stream, unsigned int first,
+                        const Building* buildings, unsigned int count);
+
+// Reallocate the vertex buffer for buildingCount slots, keeping the existing
+// vertices with a GPU-side copy. New slots are undefined until updated.
+void resizeBuildingMesh(BuildingMesh& mesh, unsigned int buildingCount);
+
+// Draw the whole mesh
+void drawBuildingMesh(const BuildingMesh& mesh);
+
+// Draw only the given building ranges with one glMultiDrawElementsBaseVertex call,
+// ranges crossing a chunk boundary are split there
+void drawBuildingMeshRanges(const BuildingMesh& mesh, const std::vector<DrawRange>& ranges);
+
+void destroyBuildingMesh(BuildingMesh& mesh);
+
+#endif
@@ -0,0 +1,275 @@
+#include "building_set.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define BUILDING_KERNEL_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BUILDING_KERNEL_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BUILDING_KERNEL_NEON
+#endif
+
+// Below this many buildings per thread the parallel overload runs serially
+static const size_t PARALLEL_MIN_BUILDINGS = 4096;
+
+// Every building is emitted as center + half extent * sign, where the 48 output
+// floats repeat with a period of two vertices (12 floats, 3 quads):
+//   Q0 = (x, y, z, r)  Q1 = (g, b, x, y)  Q2 = (z, r, g, b)
+// and the deltas are (hw, hh, hd) for positions and 0.1 for colors. The sign
+// table below selects -1/+1 per position and 0/1 (bottom/top) per color.
+static const float vertexSigns[48] = {
+    // Bottom: front-left, front-right, back-right, back-left
+    -1.0f, -1.0f,  1.0f, 0.0f, 0.0f, 0.0f,
+     1.0f, -1.0f,  1.0f, 0.0f, 0.0f, 0.0f,
+     1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+    -1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+    // Top: front-left, front-right, back-right, back-left (colors brightened by 0.1)
+    -1.0f,  1.0f,  1.0f, 1.0f, 1.0f, 1.0f,
+     1.0f,  1.0f,  1.0f, 1.0f, 1.0f, 1.0f,
+     1.0f,  1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
+    -1.0f,  1.0f, -1.0f, 1.0f, 1.0f, 1.0f
+};
+
+// Bottom, top, front, right, back, left
+static const unsigned int boxIndices[36] = {
+    0, 1, 2,  2, 3, 0,
+    4, 7, 6,  6, 5, 4,
+    0, 4, 5,  5, 1, 0,
+    1, 5, 6,  6, 2, 1,
+    2, 6, 7,  7, 3, 2,
+    3, 7, 4,  4, 0, 3
+};
+
+void toBuildingSet(const std::vector<Building>& buildings, BuildingSet& set) {
+    toBuildingSet(buildings.data(), buildings.size(), set);
+}
+
+void toBuildingSet(const Building* buildings, size_t n, BuildingSet& set) {
+    set.x.resize(n); set.y.resize(n); set.z.resize(n);
+    set.width.resize(n); set.depth.resize(n); set.height.resize(n);
+    set.r.resize(n); set.g.resize(n); set.b.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        const Building& b = buildings[i];
+        set.x[i] = b.position.x; set.y[i] = b.position.y; set.z[i] = b.position.z;
+        set.width[i] = b.width; set.depth[i] = b.depth; set.height[i] = b.height;
+        set.r[i] = b.color.r; set.g[i] = b.color.g; set.b[i] = b.color.b;
+    }
+}
+
+const char* buildingKernelName() {
+#if defined(BUILDING_KERNEL_AVX)
+    return "avx";
+#elif defined(BUILDING_KERNEL_SSE)
+    return "sse";
+#elif defined(BUILDING_KERNEL_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+// One building, used for the tail and when no SIMD kernel is available
+static void emitBuildingScalar(const BuildingSet& set, size_t i, float* v, unsigned int* idx, unsigned int base) {
+    float center[6] = { set.x[i], set.y[i], set.z[i], set.r[i], set.g[i], set.b[i] };
+    float delta[6] = { set.width[i] / 2.0f, set.height[i] / 2.0f, set.depth[i] / 2.0f, 0.1f, 0.1f, 0.1f };
+    for (int k = 0; k < 48; k++)
+        v[k] = center[k % 6] + delta[k % 6] * vertexSigns[k];
+    if (!idx)
+        return;
+    for (int k = 0; k < 36; k++)
+        idx[k] = base + boxIndices[k];
+}
+
+#if defined(BUILDING_KERNEL_SSE) || defined(BUILDING_KERNEL_AVX)
+
+// Store the 36 indices of one building
+static inline void emitIndicesSse(unsigned int* idx, unsigned int base) {
+    __m128i b = _mm_set1_epi32((int)base);
+    for (int k = 0; k < 36; k += 4) {
+        __m128i pattern = _mm_loadu_si128((const __m128i*)(boxIndices + k));
+        _mm_storeu_si128((__m128i*)(idx + k), _mm_add_epi32(pattern, b));
+    }
+}
+
+// Center/delta quads for 4 buildings, transposed from SoA lanes to one row per building
+struct BoxQuads {
+    __m128 q[3][4];
+    __m128 d[3][4];
+};
+
+static inline void transposeQuads(__m128 a, __m128 b, __m128 c, __m128 d, __m128 out[4]) {
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+    out[0] = a; out[1] = b; out[2] = c; out[3] = d;
+}
+
+static inline void loadBoxQuads(const BuildingSet& set, size_t i, BoxQuads& quads) {
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 tint = _mm_set1_ps(0.1f);
+    __m128 x = _mm_loadu_ps(&set.x[i]), y = _mm_loadu_ps(&set.y[i]), z = _mm_loadu_ps(&set.z[i]);
+    __m128 r = _mm_loadu_ps(&set.r[i]), g = _mm_loadu_ps(&set.g[i]), b = _mm_loadu_ps(&set.b[i]);
+    __m128 hw = _mm_mul_ps(_mm_loadu_ps(&set.width[i]), half);
+    __m128 hh = _mm_mul_ps(_mm_loadu_ps(&set.height[i]), half);
+    __m128 hd = _mm_mul_ps(_mm_loadu_ps(&set.depth[i]), half);
+
+    transposeQuads(x, y, z, r, quads.q[0]);
+    transposeQuads(g, b, x, y, quads.q[1]);
+    transposeQuads(z, r, g, b, quads.q[2]);
+    transposeQuads(hw, hh, hd, tint, quads.d[0]);
+    transposeQuads(tint, tint, hw, hh, quads.d[1]);
+    transposeQuads(hd, tint, tint, tint, quads.d[2]);
+}
+
+#endif
+
+#if defined(BUILDING_KERNEL_AVX)
+
+// 8 buildings per iteration: two groups of 4 transposed quads, then each building
+// is written as 6 x 256-bit stores of [Q0 Q1] [Q2 Q0] [Q1 Q2] repeated
+static void emitBuildingsSimd(const BuildingSet& set, size_t i, float* v, unsigned int* idx, unsigned int base) {
+    __m256 signs[6];
+    for (int k = 0; k < 6; k++)
+        signs[k] = _mm256_loadu_ps(vertexSigns + k * 8);
+
+    for (int group = 0; group < 2; group++) {
+        BoxQuads quads;
+        loadBoxQuads(set, i + group * 4, quads);
+        for (int lane = 0; lane < 4; lane++) {
+            __m256 c01 = _mm256_set_m128(quads.q[1][lane], quads.q[0][lane]);
+            __m256 c20 = _mm256_set_m128(quads.q[0][lane], quads.q[2][lane]);
+            __m256 c12 = _mm256_set_m128(quads.q[2][lane], quads.q[1][lane]);
+            __m256 d01 = _mm256_set_m128(quads.d[1][lane], quads.d[0][lane]);
+            __m256 d20 = _mm256_set_m128(quads.d[0][lane], quads.d[2][lane]);
+            __m256 d12 = _mm256_set_m128(quads.d[2][lane], quads.d[1][lane]);
+
+            float* out = v + (group * 4 + lane) * 48;
+            _mm256_storeu_ps(out +  0, _mm256_add_ps(c01, _mm256_mul_ps(d01, signs[0])));
+            _mm256_storeu_ps(out +  8, _mm256_add_ps(c20, _mm256_mul_ps(d20, signs[1])));
+            _mm256_storeu_ps(out + 16, _mm256_add_ps(c12, _mm256_mul_ps(d12, signs[2])));
+            _mm256_storeu_ps(out + 24, _mm256_add_ps(c01, _mm256_mul_ps(d01, signs[3])));
+            _mm256_storeu_ps(out + 32, _mm256_add_ps(c20, _mm256_mul_ps(d20, signs[4])));
+            _mm256_storeu_ps(out + 40, _mm256_add_ps(c12, _mm256_mul_ps(d12, signs[5])));
+
+            unsigned int building = group * 4 + lane;
+            if (idx)
+                emitIndicesSse(idx + building * 36, base + building * 8);
+        }
+    }
+}
+
+static const size_t BUILDINGS_PER_ITERATION = 8;
+
+#elif defined(BUILDING_KERNEL_SSE)
+
+// 4 buildings per iteration, 12 x 128-bit stores each
+static void emitBuildingsSimd(const BuildingSet& set, size_t i, float* v, unsigned int* idx, unsigned int base) {
+    BoxQuads quads;
+    loadBoxQuads(set, i, quads);
+    for (int lane = 0; lane < 4; lane++) {
+        float* out = v + lane * 48;
+        for (int k = 0; k < 12; k++) {
+            __m128 sign = _mm_loadu_ps(vertexSigns + k * 4);
+            _mm_storeu_ps(out + k * 4, _mm_add_ps(quads.q[k % 3][lane], _mm_mul_ps(quads.d[k % 3][lane], sign)));
+        }
+        if (idx)
+            emitIndicesSse(idx + lane * 36, base + lane * 8);
+    }
+}
+
+static const size_t BUILDINGS_PER_ITERATION = 4;
+
+#elif defined(BUILDING_KERNEL_NEON)
+
+// 4x4 transpose of rows a, b, c, d
+static inline void transposeQuadsNeon(float32x4_t a, float32x4_t b, float32x4_t c, float32x4_t d, float32x4_t out[4]) {
+    float32x4x2_t ab = vtrnq_f32(a, b);
+    float32x4x2_t cd = vtrnq_f32(c, d);
+    out[0] = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    out[1] = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    out[2] = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    out[3] = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+
+// 4 buildings per iteration, 12 x 128-bit stores each
+static void emitBuildingsSimd(const BuildingSet& set, size_t i, float* v, unsigned int* idx, unsigned int base) {
+    float32x4_t half = vdupq_n_f32(0.5f);
+    float32x4_t tint = vdupq_n_f32(0.1f);
+    float32x4_t x = vld1q_f32(&set.x[i]), y = vld1q_f32(&set.y[i]), z = vld1q_f32(&set.z[i]);
+    float32x4_t r = vld1q_f32(&set.r[i]), g = vld1q_f32(&set.g[i]), b = vld1q_f32(&set.b[i]);
+    float32x4_t hw = vmulq_f32(vld1q_f32(&set.width[i]), half);
+    float32x4_t hh = vmulq_f32(vld1q_f32(&set.height[i]), half);
+    float32x4_t hd = vmulq_f32(vld1q_f32(&set.depth[i]), half);
+
+    float32x4_t q[3][4], d[3][4];
+    transposeQuadsNeon(x, y, z, r, q[0]);
+    transposeQuadsNeon(g, b, x, y, q[1]);
+    transposeQuadsNeon(z, r, g, b, q[2]);
+    transposeQuadsNeon(hw, hh, hd, tint, d[0]);
+    transposeQuadsNeon(tint, tint, hw, hh, d[1]);
+    transposeQuadsNeon(hd, tint, tint, tint, d[2]);
+
+    for (int lane = 0; lane < 4; lane++) {
+        float* out = v + lane * 48;
+        for (int k = 0; k < 12; k++) {
+            // Separate multiply and add so results match the scalar path exactly
+            float32x4_t sign = vld1q_f32(vertexSigns + k * 4);
+            vst1q_f32(out + k * 4, vaddq_f32(q[k % 3][lane], vmulq_f32(d[k % 3][lane], sign)));
+        }
+
+        if (!idx)
+            continue;
+        uint32x4_t bv = vdupq_n_u32(base + lane * 8);
+        for (int k = 0; k < 36; k += 4)
+            vst1q_u32(idx + lane * 36 + k, vaddq_u32(vld1q_u32(boxIndices + k), bv));
+    }
+}
+
+static const size_t BUILDINGS_PER_ITERATION = 4;
+
+#endif
+
+// Emit buildings [begin, end); vertices, indices and baseVertex address building 0
+static void emitBuildingRange(const BuildingSet& set, size_t begin, size_t end, float* vertices,
+                              unsigned int* indices, unsigned int baseVertex) {
+    size_t i = begin;
+
+#if defined(BUILDING_KERNEL_AVX) || defined(BUILDING_KERNEL_SSE) || defined(BUILDING_KERNEL_NEON)
+    for (; i + BUILDINGS_PER_ITERATION <= end; i += BUILDINGS_PER_ITERATION)
+        emitBuildingsSimd(set, i, vertices + i * 48, indices ? indices + i * 36 : nullptr, baseVertex + i * 8);
+#endif
+
+    for (; i < end; i++)
+        emitBuildingScalar(set, i, vertices + i * 48, indices ? indices + i * 36 : nullptr, baseVertex + i * 8);
+}
+
+void createBuildingBuffers(const BuildingSet& set, float* vertices, unsigned int* indices,
+                           unsigned int baseVertex) {
+    emitBuildingRange(set, 0, set.size(), vertices, indices, baseVertex);
+}
+
+void createBuildingBuffers(const BuildingSet& set, std::vector<float>& vertices,
+                           std::vector<unsigned int>& indices, ThreadPool* pool) {
+    size_t n = set.size();
+    vertices.resize(n * 48);
+    indices.resize(n * 36);
+
+    // One contiguous range per thread, aligned so only the last one runs a scalar tail
+    size_t rangeCount = pool ? std::min((size_t)pool->size() + 1, n / PARALLEL_MIN_BUILDINGS) : 0;
+    if (rangeCount <= 1) {
+        emitBuildingRange(set, 0, n, vertices.data(), indices.data(), 0);
+        return;
+    }
+
+    size_t rangeSize = (n / rangeCount + 7) & ~(size_t)7;
+    float* v = vertices.data();
+    unsigned int* idx = indices.data();
+    pool->parallelFor(rangeCount, [&](size_t range) {
+        size_t begin = std::min(n, range * rangeSize);
+        size_t end = range + 1 == rangeCount ? n : std::min(n, begin + rangeSize);
+        emitBuildingRange(set, begin, end, v, idx, 0);
+    });
+}
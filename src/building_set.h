@@ -0,0 +1,39 @@
+#ifndef BUILDING_SET_H
+#define BUILDING_SET_H
+
+#include "city.h"
+
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+// Structure-of-arrays copy of a building list, one array per field so the
+// mesh kernel can load 4 (SSE/NEON) or 8 (AVX) buildings per instruction
+struct BuildingSet {
+    std::vector<float> x, y, z;
+    std::vector<float> width, depth, height;
+    std::vector<float> r, g, b;
+
+    size_t size() const { return x.size(); }
+};
+
+// Convert an AoS building list
+void toBuildingSet(const std::vector<Building>& buildings, BuildingSet& set);
+void toBuildingSet(const Building* buildings, size_t count, BuildingSet& set);
+
+// Name of the kernel compiled in ("avx", "sse", "neon" or "scalar")
+const char* buildingKernelName();
+
+// Emit 48 vertex floats and 36 indices per building into pre-sized buffers.
+// Output is bit-identical to createBuildingBuffers(); indices start at baseVertex.
+// indices may be null to emit vertices only.
+void createBuildingBuffers(const BuildingSet& set, float* vertices, unsigned int* indices,
+                           unsigned int baseVertex);
+
+// Convenience overload that sizes the vectors exactly before running the kernel.
+// With a pool each thread fills its own disjoint slice of both vectors.
+void createBuildingBuffers(const BuildingSet& set, std::vector<float>& vertices,
+                           std::vector<unsigned int>& indices, ThreadPool* pool);
+
+#endif
@@ -0,0 +1,81 @@
+#include "camera_path.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static CameraKey makeKey(const glm::vec3& position, const glm::vec3& front) {
+    CameraKey key;
+    key.position = position;
+    key.front = glm::normalize(front);
+    return key;
+}
+
+bool loadCameraPath(const std::string& spec, CameraPath& path) {
+    path.keys.clear();
+
+    if (spec == "static") {
+        // The interactive start pose
+        path.keys.push_back(makeKey(glm::vec3(0.0f, 50.0f, 150.0f), glm::vec3(0.0f, 0.0f, -1.0f)));
+        return true;
+    }
+
+    if (spec == "orbit") {
+        // Full circle around the city center, looking at it
+        const int steps = 64;
+        for (int i = 0; i <= steps; i++) {
+            float angle = 2.0f * 3.14159265f * i / steps;
+            glm::vec3 position(std::sin(angle) * 150.0f, 50.0f, std::cos(angle) * 150.0f);
+            path.keys.push_back(makeKey(position, glm::vec3(0.0f, 10.0f, 0.0f) - position));
+        }
+        return true;
+    }
+
+    if (spec == "flyover") {
+        // Street level pass through the city, then a climb out over the rooftops
+        path.keys.push_back(makeKey(glm::vec3(0.0f, 8.0f, 150.0f), glm::vec3(0.0f, 0.0f, -1.0f)));
+        path.keys.push_back(makeKey(glm::vec3(0.0f, 8.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)));
+        path.keys.push_back(makeKey(glm::vec3(0.0f, 120.0f, -150.0f), glm::vec3(0.0f, -0.6f, 1.0f)));
+        return true;
+    }
+
+    std::ifstream file(spec.c_str());
+    if (!file) {
+        std::cerr << "ERROR::CAMERA_PATH::OPEN_FAILED " << spec << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream fields(line);
+        glm::vec3 position, front;
+        if (fields >> position.x >> position.y >> position.z >> front.x >> front.y >> front.z)
+            path.keys.push_back(makeKey(position, front));
+    }
+    if (path.keys.empty()) {
+        std::cerr << "ERROR::CAMERA_PATH::NO_KEYS " << spec << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void sampleCameraPath(const CameraPath& path, float t, glm::vec3& position, glm::vec3& front) {
+    if (path.keys.size() == 1) {
+        position = path.keys[0].position;
+        front = path.keys[0].front;
+        return;
+    }
+
+    float scaled = glm::clamp(t, 0.0f, 1.0f) * (path.keys.size() - 1);
+    size_t index = (size_t)scaled;
+    if (index >= path.keys.size() - 1)
+        index = path.keys.size() - 2;
+    float blend = scaled - index;
+
+    const CameraKey& a = path.keys[index];
+    const CameraKey& b = path.keys[index + 1];
+    position = glm::mix(a.position, b.position, blend);
+    front = glm::normalize(glm::mix(a.front, b.front, blend));
+}
@@ -0,0 +1,27 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// One camera pose along a path
+struct CameraKey {
+    glm::vec3 position;
+    glm::vec3 front;
+};
+
+// Keyframes visited at uniform spacing over t in [0, 1]
+struct CameraPath {
+    std::vector<CameraKey> keys;
+};
+
+// Build a path from "static", "orbit", "flyover" or a text file with one
+// "px py pz fx fy fz" key per line; returns false if the file can't be read
+bool loadCameraPath(const std::string& spec, CameraPath& path);
+
+// Interpolated pose at t in [0, 1]
+void sampleCameraPath(const CameraPath& path, float t, glm::vec3& position, glm::vec3& front);
+
+#endif
@@ -0,0 +1,106 @@
+#include "chunk_arena.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+static unsigned int slotCapacity(const ChunkArena& arena) {
+    return arena.instanced ? arena.instancedMesh.instanceCount : arena.buildingMesh.buildingCount;
+}
+
+// Put [first, first + count) back in order, joined to the free runs it touches
+static void insertFreeSlots(ChunkArena& arena, unsigned int first, unsigned int count) {
+    std::vector<DrawRange>& slots = arena.freeSlots;
+    DrawRange range = { first, count };
+    std::vector<DrawRange>::iterator next = std::lower_bound(
+        slots.begin(), slots.end(), range, [](const DrawRange& a, const DrawRange& b) { return a.first < b.first; });
+    next = slots.insert(next, range);
+
+    if (next + 1 != slots.end() && next->first + next->count == (next + 1)->first) {
+        next->count += (next + 1)->count;
+        slots.erase(next + 1);
+    }
+    if (next != slots.begin() && (next - 1)->first + (next - 1)->count == next->first) {
+        (next - 1)->count += next->count;
+        slots.erase(next);
+    }
+}
+
+ChunkArena createChunkArena(bool instanced, unsigned int capacity) {
+    ChunkArena arena = ChunkArena();
+    arena.instanced = instanced;
+    if (instanced)
+        arena.instancedMesh = createInstancedMesh(nullptr, capacity, nullptr);
+    else
+        arena.buildingMesh = createBuildingMesh(nullptr, (size_t)capacity * 48, false, nullptr);
+    if (capacity)
+        insertFreeSlots(arena, 0, capacity);
+    return arena;
+}
+
+unsigned int allocateArenaSlots(ChunkArena& arena, unsigned int count) {
+    std::vector<DrawRange>& slots = arena.freeSlots;
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (slots[i].count < count)
+            continue;
+        unsigned int first = slots[i].first;
+        slots[i].first += count;
+        slots[i].count -= count;
+        if (!slots[i].count)
+            slots.erase(slots.begin() + i);
+        return first;
+    }
+
+    // Grow, the new tail joins a free run that already ends at the old capacity
+    unsigned int capacity = slotCapacity(arena);
+    unsigned int grown = std::max(capacity * 2, capacity + count);
+    if (arena.instanced)
+        resizeInstancedMesh(arena.instancedMesh, grown);
+    else
+        resizeBuildingMesh(arena.buildingMesh, grown);
+    insertFreeSlots(arena, capacity, grown - capacity);
+    return allocateArenaSlots(arena, count);
+}
+
+void releaseArenaSlots(ChunkArena& arena, unsigned int first, unsigned int count) {
+    if (count)
+        insertFreeSlots(arena, first, count);
+}
+
+// Into buffer at offset through the ring, or directly without one
+static void writeArenaBytes(unsigned int buffer, StreamBuffer* stream, size_t offset, const void* data, size_t bytes) {
+    if (stream) {
+        streamUpload(*stream, buffer, offset, data, bytes);
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+    }
+}
+
+void writeArenaVertices(ChunkArena& arena, StreamBuffer* stream, unsigned int first, const float* vertices,
+                        unsigned int count) {
+    writeArenaBytes(arena.buildingMesh.VBO, stream, (size_t)first * 48 * sizeof(float), vertices,
+                    (size_t)count * 48 * sizeof(float));
+}
+
+void writeArenaInstances(ChunkArena& arena, StreamBuffer* stream, unsigned int first,
+                         const BuildingInstance* instances, unsigned int count) {
+    writeArenaBytes(arena.instancedMesh.instanceVBO, stream, (size_t)first * sizeof(BuildingInstance), instances,
+                    (size_t)count * sizeof(BuildingInstance));
+}
+
+void queueArenaRanges(RenderQueue& queue, unsigned int program, int level, float distance, const ChunkArena& arena,
+                      unsigned int firstSlot, const std::vector<DrawRange>& ranges) {
+    if (arena.instanced)
+        queueInstancedMesh(queue, program, level, distance, arena.instancedMesh, ranges, firstSlot);
+    else
+        queueBuildingMesh(queue, program, level, distance, arena.buildingMesh, ranges, firstSlot);
+}
+
+void destroyChunkArena(ChunkArena& arena) {
+    if (arena.instanced)
+        destroyInstancedMesh(arena.instancedMesh);
+    else
+        destroyBuildingMesh(arena.buildingMesh);
+    arena.freeSlots.clear();
+}
@@ -0,0 +1,47 @@
+#ifndef CHUNK_ARENA_H
+#define CHUNK_ARENA_H
+
+#include "building_mesh.h"
+#include "instancing.h"
+#include "render_queue.h"
+#include "spatial_grid.h"
+#include "stream_buffer.h"
+
+#include <vector>
+
+// One vertex or instance buffer shared by every streamed chunk of a layout.
+// Chunks own runs of building slots inside it, so they also share the VAO and
+// the single chunk index buffer: range [first, first + count) of a chunk whose
+// run starts at slot is arena range [slot + first, ...), and the ranges of any
+// number of chunks go into one glMultiDrawElementsBaseVertex.
+struct ChunkArena {
+    bool instanced;
+    BuildingMesh buildingMesh;   // float layout, buildingCount is the slot capacity
+    InstancedMesh instancedMesh; // instanced layout, instanceCount is the slot capacity
+    std::vector<DrawRange> freeSlots; // sorted by first, neighbours always coalesced
+};
+
+// Allocate capacity slots up front, nothing is uploaded yet
+ChunkArena createChunkArena(bool instanced, unsigned int capacity);
+
+// Reserve count contiguous slots, first fit. When none fits the buffer at least
+// doubles with a GPU-side copy, slots already handed out keep their place.
+unsigned int allocateArenaSlots(ChunkArena& arena, unsigned int count);
+
+// Hand slots back, their contents stay until the next chunk overwrites them
+void releaseArenaSlots(ChunkArena& arena, unsigned int first, unsigned int count);
+
+// Upload baked float vertices (48 per building) or instance records into
+// the slots from first on, staged through stream when one is given
+void writeArenaVertices(ChunkArena& arena, StreamBuffer* stream, unsigned int first, const float* vertices,
+                        unsigned int count);
+void writeArenaInstances(ChunkArena& arena, StreamBuffer* stream, unsigned int first,
+                         const BuildingInstance* instances, unsigned int count);
+
+// Queue the ranges of a chunk whose run of slots starts at firstSlot
+void queueArenaRanges(RenderQueue& queue, unsigned int program, int level, float distance, const ChunkArena& arena,
+                      unsigned int firstSlot, const std::vector<DrawRange>& ranges);
+
+void destroyChunkArena(ChunkArena& arena);
+
+#endif
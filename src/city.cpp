@@ -0,0 +1,157 @@
+#include "city.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+// Buildings per independent RNG stream
+static const int GENERATION_BLOCK_SIZE = 4096;
+
+void generateCity(std::vector<Building>& buildings, int numBuildings) {
+    generateCity(buildings, numBuildings,
+                 (unsigned int)std::chrono::steady_clock::now().time_since_epoch().count(), nullptr);
+}
+
+void generateCity(std::vector<Building>& buildings, int numBuildings, unsigned int seed, ThreadPool* pool) {
+    // Preallocate so every block writes its own slice, no push_back or locking
+    size_t base = buildings.size();
+    buildings.resize(base + numBuildings);
+    Building* out = buildings.data() + base;
+
+    // Blocks are a fixed size so the streams, and the output, don't depend on the thread count
+    size_t blockCount = (numBuildings + GENERATION_BLOCK_SIZE - 1) / GENERATION_BLOCK_SIZE;
+    std::function<void(size_t)> generateBlock = [=](size_t block) {
+        int first = block * GENERATION_BLOCK_SIZE;
+        int count = std::min(GENERATION_BLOCK_SIZE, numBuildings - first);
+        CounterRng rng(streamKey(seed, block));
+        generateBuildings(rng, out + first, count, first, -100.0f, 100.0f, -100.0f, 100.0f);
+    };
+
+    if (pool) {
+        pool->parallelFor(blockCount, generateBlock);
+    } else {
+        for (size_t block = 0; block < blockCount; block++)
+            generateBlock(block);
+    }
+
+    // Add ground plane
+    buildings.push_back(createGround(0.0f, 0.0f, 250.0f, 250.0f));
+}
+
+void generateBuildings(CounterRng& rng, Building* out, int numBuildings, int firstIndex,
+                       float minX, float maxX, float minZ, float maxZ) {
+    for (int i = 0; i < numBuildings; i++) {
+        // Draw in a fixed order, argument evaluation order is unspecified
+        Building building;
+        float x = rng.uniform(minX, maxX);
+        float z = rng.uniform(minZ, maxZ);
+        building.position = glm::vec3(x, 0.0f, z);
+        building.width = rng.uniform(5.0f, 15.0f);
+        building.depth = rng.uniform(5.0f, 15.0f);
+        building.height = rng.uniform(10.0f, 60.0f);
+
+        float r = rng.uniform(0.2f, 0.8f);
+        float g = rng.uniform(0.2f, 0.8f);
+        float b = rng.uniform(0.2f, 0.8f);
+
+        // Night city colors - blues, purples, etc.
+        if ((firstIndex + i) % 5 == 0) {
+            // Make some buildings emit more light (bright colors)
+            building.color = glm::vec3(r * 0.5f + 0.5f, g * 0.5f + 0.5f, b * 0.5f + 0.5f);
+        } else {
+            // Regular buildings, more muted colors
+            building.color = glm::vec3(r * 0.3f, g * 0.3f, b * 0.5f + 0.3f);
+        }
+
+        out[i] = building;
+    }
+}
+
+Building createGround(float centerX, float centerZ, float width, float depth) {
+    Building ground;
+    ground.position = glm::vec3(centerX, -0.5f, centerZ);
+    ground.width = width;
+    ground.depth = depth;
+    ground.height = 1.0f;
+    ground.color = glm::vec3(0.1f, 0.1f, 0.1f); // Dark gray
+    return ground;
+}
+
+void createBuildingBuffers(const std::vector<Building>& buildings, 
+                          std::vector<float>& vertices, 
+                          std::vector<unsigned int>& indices) {
+    for (size_t i = 0; i < buildings.size(); i++) {
+        const Building& b = buildings[i];
+        
+        // Calculate half dimensions for convenience
+        float hw = b.width / 2.0f;
+        float hh = b.height / 2.0f;
+        float hd = b.depth / 2.0f;
+        
+        // Base index for this building
+        unsigned int baseIndex = vertices.size() / 6;
+
+        // Each vertex has: position (3 floats) + color (3 floats)
+        // Define 8 vertices of the building (a cube)
+        
+        // Bottom vertices
+        // Front-left
+        vertices.push_back(b.position.x - hw); vertices.push_back(b.position.y - hh); vertices.push_back(b.position.z + hd);
+        vertices.push_back(b.color.r); vertices.push_back(b.color.g); vertices.push_back(b.color.b);
+        
+        // Front-right
+        vertices.push_back(b.position.x + hw); vertices.push_back(b.position.y - hh); vertices.push_back(b.position.z + hd);
+        vertices.push_back(b.color.r); vertices.push_back(b.color.g); vertices.push_back(b.color.b);
+        
+        // Back-right
+        vertices.push_back(b.position.x + hw); vertices.push_back(b.position.y - hh); vertices.push_back(b.position.z - hd);
+        vertices.push_back(b.color.r); vertices.push_back(b.color.g); vertices.push_back(b.color.b);
+        
+        // Back-left
+        vertices.push_back(b.position.x - hw); vertices.push_back(b.position.y - hh); vertices.push_back(b.position.z - hd);
+        vertices.push_back(b.color.r); vertices.push_back(b.color.g); vertices.push_back(b.color.b);
+        
+        // Top vertices
+        // Front-left
+        vertices.push_back(b.position.x - hw); vertices.push_back(b.position.y + hh); vertices.push_back(b.position.z + hd);
+        vertices.push_back(b.color.r + 0.1f); vertices.push_back(b.color.g + 0.1f); vertices.push_back(b.color.b + 0.1f);
+        
+        // Front-right
+        vertices.push_back(b.position.x + hw); vertices.push_back(b.position.y + hh); vertices.push_back(b.position.z + hd);
+        vertices.push_back(b.color.r + 0.1f); vertices.push_back(b.color.g + 0.1f); vertices.push_back(b.color.b + 0.1f);
+        
+        // Back-right
+        vertices.push_back(b.position.x + hw); vertices.push_back(b.position.y + hh); vertices.push_back(b.position.z - hd);
+        vertices.push_back(b.color.r + 0.1f); vertices.push_back(b.color.g + 0.1f); vertices.push_back(b.color.b + 0.1f);
+        
+        // Back-left
+        vertices.push_back(b.position.x - hw); vertices.push_back(b.position.y + hh); vertices.push_back(b.position.z - hd);
+        vertices.push_back(b.color.r + 0.1f); vertices.push_back(b.color.g + 0.1f); vertices.push_back(b.color.b + 0.1f);
+        
+        // Define the 12 triangles (6 faces, 2 triangles per face)
+        // Bottom face
+        indices.push_back(baseIndex + 0); indices.push_back(baseIndex + 1); indices.push_back(baseIndex + 2);
+        indices.push_back(baseIndex + 2); indices.push_back(baseIndex + 3); indices.push_back(baseIndex + 0);
+        
+        // Top face
+        indices.push_back(baseIndex + 4); indices.push_back(baseIndex + 7); indices.push_back(baseIndex + 6);
+        indices.push_back(baseIndex + 6); indices.push_back(baseIndex + 5); indices.push_back(baseIndex + 4);
+        
+        // Front face
+        indices.push_back(baseIndex + 0); indices.push_back(baseIndex + 4); indices.push_back(baseIndex + 5);
+        indices.push_back(baseIndex + 5); indices.push_back(baseIndex + 1); indices.push_back(baseIndex + 0);
+        
+        // Right face
+        indices.push_back(baseIndex + 1); indices.push_back(baseIndex + 5); indices.push_back(baseIndex + 6);
+        indices.push_back(baseIndex + 6); indices.push_back(baseIndex + 2); indices.push_back(baseIndex + 1);
+        
+        // Back face
+        indices.push_back(baseIndex + 2); indices.push_back(baseIndex + 6); indices.push_back(baseIndex + 7);
+        indices.push_back(baseIndex + 7); indices.push_back(baseIndex + 3); indices.push_back(baseIndex + 2);
+        
+        // Left face
+        indices.push_back(baseIndex + 3); indices.push_back(baseIndex + 7); indices.push_back(baseIndex + 4);
+        indices.push_back(baseIndex + 4); indices.push_back(baseIndex + 0); indices.push_back(baseIndex + 3);
+    }
+}
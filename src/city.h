@@ -0,0 +1,42 @@
+#ifndef CITY_H
+#define CITY_H
+
+#include <glm/glm.hpp>
+
+#include "random.h"
+
+#include <vector>
+
+class ThreadPool;
+
+// Building structure
+struct Building {
+    glm::vec3 position;
+    float width;
+    float depth;
+    float height;
+    glm::vec3 color;
+};
+
+// Fill buildings with numBuildings random boxes followed by the ground plane
+void generateCity(std::vector<Building>& buildings, int numBuildings);
+
+// Seeded variant. Work is split into fixed-size blocks, each with its own counter-based
+// stream writing into preallocated storage, so the output is bit-identical for a given
+// seed whether it runs on a pool of any size or on the calling thread (pool == nullptr).
+void generateCity(std::vector<Building>& buildings, int numBuildings, unsigned int seed, ThreadPool* pool);
+
+// Write numBuildings random boxes with centers inside [minX, maxX) x [minZ, maxZ) to out.
+// firstIndex is the city-wide index of out[0], every fifth building is a bright one.
+void generateBuildings(CounterRng& rng, Building* out, int numBuildings, int firstIndex,
+                       float minX, float maxX, float minZ, float maxZ);
+
+// One unit-high dark slab with its top face at y = 0
+Building createGround(float centerX, float centerZ, float width, float depth);
+
+// Bake every building into 8 interleaved vertices (position + color) and 36 indices
+void createBuildingBuffers(const std::vector<Building>& buildings, 
+                          std::vector<float>& vertices, 
+                          std::vector<unsigned int>& indices);
+
+#endif
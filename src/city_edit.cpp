@@ -0,0 +1,360 @@
+#include "city_edit.h"
+#include "scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+
+// New contents of every cell an edit touches, keyed by cell index
+typedef std::map<unsigned int, std::vector<Building> > CellContents;
+
+// Extra slots a relocated cell gets so the next few additions stay in place
+static unsigned int cellSlack(unsigned int count) {
+    return std::max(8u, count / 2);
+}
+
+// Zero-sized box, its vertices collapse to one point and nothing is rasterized
+static Building holeBuilding() {
+    Building b;
+    b.position = glm::vec3(0.0f);
+    b.width = 0.0f;
+    b.depth = 0.0f;
+    b.height = 0.0f;
+    b.color = glm::vec3(0.0f);
+    return b;
+}
+
+static bool insideRegion(const Building& b, const glm::vec3& regionMin, const glm::vec3& regionMax) {
+    return b.position.x >= regionMin.x && b.position.x <= regionMax.x &&
+           b.position.z >= regionMin.z && b.position.z <= regionMax.z;
+}
+
+// Cell owning a building center, clamped to the border cells like buildSpatialGrid()
+static unsigned int cellAt(const SpatialGrid& grid, const glm::vec3& position) {
+    int cx = (int)std::floor((position.x - grid.originX) / grid.cellSize);
+    int cz = (int)std::floor((position.z - grid.originZ) / grid.cellSize);
+    cx = std::max(0, std::min(cx, grid.columns - 1));
+    cz = std::max(0, std::min(cz, grid.rows - 1));
+    return cz * grid.columns + cx;
+}
+
+// Cells whose buildings may have centers inside the region
+static bool cellTouchesRegion(const SpatialGrid& grid, unsigned int c, const glm::vec3& regionMin,
+                              const glm::vec3& regionMax) {
+    const GridCell& cell = grid.cells[c];
+    return cell.count && cell.boundsMin.x <= regionMax.x && cell.boundsMax.x >= regionMin.x &&
+           cell.boundsMin.z <= regionMax.z && cell.boundsMax.z >= regionMin.z;
+}
+
+// The edited copy of cell c, taken from the scene the first time it is asked for
+static std::vector<Building>& cellContents(const CityScene& scene, CellContents& cells, unsigned int c) {
+    CellContents::iterator it = cells.find(c);
+    if (it != cells.end())
+        return it->second;
+    const GridCell& cell = scene.grid.cells[c];
+    std::vector<Building>& members = cells[c];
+    members.assign(scene.buildings.begin() + cell.first, scene.buildings.begin() + cell.first + cell.count);
+    return members;
+}
+
+static bool editable(const CityScene& scene) {
+    if (scene.world) {
+        std::cerr << "ERROR::EDIT::STREAMED_WORLD" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static void ensureEditState(CityScene& scene) {
+    CityEditState& state = scene.editState;
+    if (state.initialized)
+        return;
+
+    state.cellCapacity.resize(scene.grid.cells.size());
+    for (size_t c = 0; c < scene.grid.cells.size(); c++)
+        state.cellCapacity[c] = scene.grid.cells[c].count;
+    if (scene.lodSettings.enabled && !scene.gpuCull)
+        buildLodProxies(scene.grid, scene.buildings, scene.lodSettings.blockDivisions, state.lodProxies);
+    state.relocatedCells = 0;
+    state.initialized = true;
+}
+
+// GPU culler commands and LOD proxies follow the grid; dirtyCells null rebuilds them all
+static void refreshCullingData(CityScene& scene, const std::vector<unsigned char>* dirtyCells) {
+    if (scene.gpuCull) {
+        destroyGpuCuller(scene.gpuCuller);
+        scene.gpuCuller = scene.instanced ? createGpuCuller(scene.instancedMesh) : createGpuCuller(scene.grid);
+        scene.gpuCull = scene.gpuCuller.program != 0;
+        return;
+    }
+    if (!scene.lodSettings.enabled)
+        return;
+
+    CityEditState& state = scene.editState;
+    if (dirtyCells)
+        updateLodProxies(scene.grid, scene.buildings, scene.lodSettings.blockDivisions, *dirtyCells, state.lodProxies);
+    destroyLodGeometry(scene.lod);
+    LodProxies proxies = state.lodProxies;
+    scene.lod = createLodGeometry(proxies, scene.instanced, scene.packedVertices, nullptr);
+}
+
+// Full rebuild from the live buildings, compacting away every hole
+static void rebuildCity(CityScene& scene, const CellContents& cells) {
+    std::vector<Building> live;
+    for (size_t c = 0; c < scene.grid.cells.size(); c++) {
+        CellContents::const_iterator it = cells.find(c);
+        const GridCell& cell = scene.grid.cells[c];
+        if (it != cells.end())
+            live.insert(live.end(), it->second.begin(), it->second.end());
+        else
+            live.insert(live.end(), scene.buildings.begin() + cell.first, scene.buildings.begin() + cell.first + cell.count);
+    }
+    for (size_t i = 0; i < scene.grid.oversized.size(); i++)
+        live.push_back(scene.buildings[scene.grid.oversized[i].first]);
+    if (scene.grid.cells.empty()) {
+        // No grid to place them in yet, they all arrive under cell 0
+        CellContents::const_iterator it = cells.find(0);
+        if (it != cells.end())
+            live.insert(live.end(), it->second.begin(), it->second.end());
+    }
+
+    scene.buildings.swap(live);
+    scene.grid = buildSpatialGrid(scene.buildings, scene.grid.cellSize);
+    if (scene.instanced) {
+        destroyInstancedMesh(scene.instancedMesh);
+        scene.instancedMesh = createInstancedMesh(scene.buildings, nullptr, nullptr);
+    } else {
+        destroyBuildingMesh(scene.buildingMesh);
+        scene.buildingMesh = createBuildingMesh(scene.buildings, scene.packedVertices, nullptr, nullptr);
+    }
+
+    scene.editState.initialized = false;
+    ensureEditState(scene);
+    refreshCullingData(scene, nullptr);
+    if (scene.occlusion) {
+        float occluderDistance = scene.occlusionCuller.occluderDistance;
+        destroyOcclusionCuller(scene.occlusionCuller);
+        scene.occlusionCuller = createOcclusionCuller(scene.grid, occluderDistance);
+    }
+}
+
+// Packed meshes keep their quantization frame, a building outside it would be clamped
+static bool fitsQuantization(const CityScene& scene, const CellContents& cells) {
+    if (!scene.packedVertices)
+        return true;
+    const BuildingMesh& mesh = scene.buildingMesh;
+    glm::vec3 frameMax = mesh.quantOrigin + mesh.quantScale;
+    for (CellContents::const_iterator it = cells.begin(); it != cells.end(); ++it) {
+        for (size_t i = 0; i < it->second.size(); i++) {
+            glm::vec3 bMin, bMax;
+            buildingBounds(it->second[i], bMin, bMax);
+            if (bMin.x < mesh.quantOrigin.x || bMin.y < mesh.quantOrigin.y || bMin.z < mesh.quantOrigin.z ||
+                bMax.x > frameMax.x || bMax.y > frameMax.y || bMax.z > frameMax.z)
+                return false;
+        }
+    }
+    return true;
+}
+
+// Write the new cell contents into their slots and patch exactly those slots on the GPU
+static void applyCellContents(CityScene& scene, const CellContents& cells) {
+    if (cells.empty())
+        return;
+    scene.revision++;
+    if (scene.grid.cells.empty() || !fitsQuantization(scene, cells)) {
+        rebuildCity(scene, cells);
+        return;
+    }
+
+    CityEditState& state = scene.editState;
+    SpatialGrid& grid = scene.grid;
+    std::vector<DrawRange> patches;
+    std::vector<unsigned char> dirtyCells(grid.cells.size(), 0);
+
+    // Cells that outgrow their slots move to the end, leaving holes behind
+    unsigned int slotCount = scene.buildings.size();
+    std::vector<unsigned int> patchCounts;
+    for (CellContents::const_iterator it = cells.begin(); it != cells.end(); ++it) {
+        GridCell& cell = grid.cells[it->first];
+        unsigned int count = it->second.size();
+        unsigned int patchCount = std::max(count, cell.count);
+        if (count > state.cellCapacity[it->first]) {
+            std::fill(scene.buildings.begin() + cell.first, scene.buildings.begin() + cell.first + cell.count,
+                      holeBuilding());
+            appendDrawRange(patches, cell.first, cell.count);
+            cell.first = slotCount;
+            state.cellCapacity[it->first] = count + cellSlack(count);
+            slotCount += state.cellCapacity[it->first];
+            patchCount = state.cellCapacity[it->first];
+            state.relocatedCells++;
+        }
+        patchCounts.push_back(patchCount);
+    }
+
+    // Grow the GPU buffers once per edit; every new slot is covered by a patch below
+    if (slotCount > scene.buildings.size()) {
+        scene.buildings.resize(slotCount, holeBuilding());
+        if (scene.instanced)
+            resizeInstancedMesh(scene.instancedMesh, slotCount);
+        else
+            resizeBuildingMesh(scene.buildingMesh, slotCount);
+    }
+
+    size_t k = 0;
+    for (CellContents::const_iterator it = cells.begin(); it != cells.end(); ++it, k++) {
+        GridCell& cell = grid.cells[it->first];
+        const std::vector<Building>& members = it->second;
+        std::copy(members.begin(), members.end(), scene.buildings.begin() + cell.first);
+        std::fill(scene.buildings.begin() + cell.first + members.size(),
+                  scene.buildings.begin() + cell.first + patchCounts[k], holeBuilding());
+        appendDrawRange(patches, cell.first, patchCounts[k]);
+
+        cell.count = members.size();
+        for (unsigned int i = 0; i < cell.count; i++) {
+            glm::vec3 bMin, bMax;
+            buildingBounds(members[i], bMin, bMax);
+            cell.boundsMin = i ? glm::min(cell.boundsMin, bMin) : bMin;
+            cell.boundsMax = i ? glm::max(cell.boundsMax, bMax) : bMax;
+        }
+        dirtyCells[it->first] = 1;
+    }
+
+    // Merge neighbouring slot ranges so each contiguous run is one ring upload
+    std::sort(patches.begin(), patches.end(), [](const DrawRange& a, const DrawRange& b) { return a.first < b.first; });
+    std::vector<DrawRange> merged;
+    for (size_t i = 0; i < patches.size(); i++) {
+        if (!patches[i].count)
+            continue;
+        if (!merged.empty() && patches[i].first <= merged.back().first + merged.back().count) {
+            unsigned int end = std::max(merged.back().first + merged.back().count, patches[i].first + patches[i].count);
+            merged.back().count = end - merged.back().first;
+        } else {
+            merged.push_back(patches[i]);
+        }
+    }
+    for (size_t i = 0; i < merged.size(); i++) {
+        const Building* source = &scene.buildings[merged[i].first];
+        if (scene.instanced)
+            updateInstancedMesh(scene.instancedMesh, scene.stream, merged[i].first, source, merged[i].count);
+        else
+            updateBuildingMesh(scene.buildingMesh, scene.stream, merged[i].first, source, merged[i].count);
+    }
+
+    refreshCullingData(scene, &dirtyCells);
+}
+
+// Drop the buildings inside the region from the cells they live in
+static unsigned int collectRemovals(const CityScene& scene, const glm::vec3& regionMin, const glm::vec3& regionMax,
+                                    CellContents& cells) {
+    unsigned int removed = 0;
+    for (unsigned int c = 0; c < scene.grid.cells.size(); c++) {
+        if (!cellTouchesRegion(scene.grid, c, regionMin, regionMax))
+            continue;
+        const GridCell& cell = scene.grid.cells[c];
+        std::vector<Building> kept;
+        for (unsigned int i = cell.first; i < cell.first + cell.count; i++) {
+            if (!insideRegion(scene.buildings[i], regionMin, regionMax))
+                kept.push_back(scene.buildings[i]);
+        }
+        if (kept.size() == cell.count)
+            continue;
+        removed += cell.count - kept.size();
+        cells[c].swap(kept);
+    }
+    return removed;
+}
+
+static void collectAdditions(const CityScene& scene, const std::vector<Building>& buildings, CellContents& cells) {
+    for (size_t i = 0; i < buildings.size(); i++) {
+        unsigned int c = scene.grid.cells.empty() ? 0 : cellAt(scene.grid, buildings[i].position);
+        if (scene.grid.cells.empty())
+            cells[c].push_back(buildings[i]);
+        else
+            cellContents(scene, cells, c).push_back(buildings[i]);
+    }
+}
+
+bool removeBuildings(CityScene& scene, const glm::vec3& regionMin, const glm::vec3& regionMax,
+                     unsigned int& removed) {
+    removed = 0;
+    if (!editable(scene))
+        return false;
+    ensureEditState(scene);
+
+    CellContents cells;
+    removed = collectRemovals(scene, regionMin, regionMax, cells);
+    applyCellContents(scene, cells);
+    return true;
+}
+
+bool modifyBuildings(CityScene& scene, const glm::vec3& regionMin, const glm::vec3& regionMax,
+                     const std::function<void(Building&)>& edit, unsigned int& modified) {
+    modified = 0;
+    if (!editable(scene))
+        return false;
+    ensureEditState(scene);
+
+    // Buildings that leave their cell are placed after every cell was edited, so none is edited twice
+    CellContents cells;
+    std::vector<Building> moved;
+    for (unsigned int c = 0; c < scene.grid.cells.size(); c++) {
+        if (!cellTouchesRegion(scene.grid, c, regionMin, regionMax))
+            continue;
+        const GridCell& cell = scene.grid.cells[c];
+        bool touched = false;
+        for (unsigned int i = cell.first; i < cell.first + cell.count && !touched; i++)
+            touched = insideRegion(scene.buildings[i], regionMin, regionMax);
+        if (!touched)
+            continue;
+
+        std::vector<Building>& members = cellContents(scene, cells, c);
+        std::vector<Building> kept;
+        for (size_t i = 0; i < members.size(); i++) {
+            Building b = members[i];
+            if (insideRegion(b, regionMin, regionMax)) {
+                edit(b);
+                modified++;
+                if (cellAt(scene.grid, b.position) != c) {
+                    moved.push_back(b);
+                    continue;
+                }
+            }
+            kept.push_back(b);
+        }
+        members.swap(kept);
+    }
+    collectAdditions(scene, moved, cells);
+    applyCellContents(scene, cells);
+    return true;
+}
+
+bool addBuildings(CityScene& scene, const std::vector<Building>& buildings) {
+    if (!editable(scene))
+        return false;
+    ensureEditState(scene);
+
+    CellContents cells;
+    collectAdditions(scene, buildings, cells);
+    applyCellContents(scene, cells);
+    return true;
+}
+
+bool regenerateRegion(CityScene& scene, const glm::vec3& regionMin, const glm::vec3& regionMax,
+                      int count, unsigned int seed) {
+    if (!editable(scene))
+        return false;
+    ensureEditState(scene);
+
+    CellContents cells;
+    unsigned int removed = collectRemovals(scene, regionMin, regionMax, cells);
+
+    // Same generator as the startup city, one stream per seed
+    std::vector<Building> fresh(count < 0 ? removed : count);
+    CounterRng rng(streamKey(seed, 0));
+    generateBuildings(rng, fresh.data(), fresh.size(), 0, regionMin.x, regionMax.x, regionMin.z, regionMax.z);
+
+    collectAdditions(scene, fresh, cells);
+    applyCellContents(scene, cells);
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef CITY_EDIT_H
+#define CITY_EDIT_H
+
+#include "city.h"
+#include "lod.h"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <vector>
+
+struct CityScene;
+
+// Bookkeeping that lets a fixed city be edited in place. Every grid cell owns
+// capacity slots starting at its first building; a cell that outgrows them
+// moves to the end of the buffers with some slack. Slots nobody uses hold
+// zero-sized holes, so drawing any range of the mesh stays valid.
+struct CityEditState {
+    bool initialized;
+    std::vector<unsigned int> cellCapacity;
+    LodProxies lodProxies; // per-cell proxies, only edited cells are rebuilt
+    unsigned int relocatedCells;
+};
+
+// Regions are XZ rectangles; a building is inside when its center is.
+// Oversized buildings (the ground) are never touched. Only the grid cells a
+// change lands in are rebaked and only their slots are patched through the
+// scene's staging ring, followed by their LOD proxies and the GPU culler.
+// All of these return false (and leave the scene as it was) for a streamed
+// world, which has no editable CPU copy.
+
+// Remove every building inside the region, removed is the number dropped
+bool removeBuildings(CityScene& scene, const glm::vec3& regionMin, const glm::vec3& regionMax,
+                     unsigned int& removed);
+
+// Run edit on every building inside the region. It may move, resize or
+// recolor the building; one that moves lands in the cell of its new center.
+bool modifyBuildings(CityScene& scene, const glm::vec3& regionMin, const glm::vec3& regionMax,
+                     const std::function<void(Building&)>& edit, unsigned int& modified);
+
+// Add buildings to the cells containing their centers (the nearest border
+// cell for centers outside the grid)
+bool addBuildings(CityScene& scene, const std::vector<Building>& buildings);
+
+// Replace the buildings inside the region with count freshly generated ones
+bool regenerateRegion(CityScene& scene, const glm::vec3& regionMin, const glm::vec3& regionMax,
+                      int count, unsigned int seed);
+
+#endif
@@ -0,0 +1,237 @@
+#include "city_layout.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+// Average buildings per block; about a third of a block ends up built on
+static const int LAYOUT_BLOCK_BUILDINGS = 10;
+
+// Gap kept between lots and between neighbouring buildings
+static const float LAYOUT_LOT_SETBACK = 1.5f;
+static const float LAYOUT_BUILDING_GAP = 1.0f;
+
+// Placement tries per size step; each step halves the footprint range (sides of a third up to
+// all of 15 units or the building's share of its lot)
+static const int LAYOUT_ATTEMPTS = 24;
+static const int LAYOUT_SIZE_STEPS = 3;
+
+// Footprint hash buckets: world units per bucket and table size (a power of two)
+static const float FOOTPRINT_BUCKET_SIZE = 8.0f;
+static const unsigned int FOOTPRINT_BUCKETS = 64;
+
+struct Footprint {
+    float minX, minZ, maxX, maxZ;
+};
+
+// Spatial hash of placed footprints, each registered in every bucket it touches
+class FootprintHash {
+public:
+    FootprintHash() : buckets(FOOTPRINT_BUCKETS) {}
+
+    void clear() {
+        for (size_t i = 0; i < buckets.size(); i++)
+            buckets[i].clear();
+        footprints.clear();
+    }
+
+    // True when box comes closer than gap to any footprint already inserted
+    bool overlaps(const Footprint& box, float gap) const {
+        int x0, z0, x1, z1;
+        bucketRange(box, x0, z0, x1, z1);
+        for (int z = z0; z <= z1; z++) {
+            for (int x = x0; x <= x1; x++) {
+                const std::vector<unsigned int>& bucket = buckets[bucketIndex(x, z)];
+                for (size_t i = 0; i < bucket.size(); i++) {
+                    const Footprint& other = footprints[bucket[i]];
+                    if (box.minX < other.maxX + gap && other.minX < box.maxX + gap &&
+                        box.minZ < other.maxZ + gap && other.minZ < box.maxZ + gap)
+                        return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void insert(const Footprint& box) {
+        unsigned int index = footprints.size();
+        footprints.push_back(box);
+        int x0, z0, x1, z1;
+        bucketRange(box, x0, z0, x1, z1);
+        for (int z = z0; z <= z1; z++)
+            for (int x = x0; x <= x1; x++)
+                buckets[bucketIndex(x, z)].push_back(index);
+    }
+
+private:
+    // Buckets touched by box grown by the largest gap, so neighbours within it are found
+    static void bucketRange(const Footprint& box, int& x0, int& z0, int& x1, int& z1) {
+        x0 = (int)std::floor((box.minX - LAYOUT_BUILDING_GAP) / FOOTPRINT_BUCKET_SIZE);
+        z0 = (int)std::floor((box.minZ - LAYOUT_BUILDING_GAP) / FOOTPRINT_BUCKET_SIZE);
+        x1 = (int)std::floor((box.maxX + LAYOUT_BUILDING_GAP) / FOOTPRINT_BUCKET_SIZE);
+        z1 = (int)std::floor((box.maxZ + LAYOUT_BUILDING_GAP) / FOOTPRINT_BUCKET_SIZE);
+    }
+
+    static unsigned int bucketIndex(int x, int z) {
+        return ((unsigned int)x * 73856093u ^ (unsigned int)z * 19349663u) & (FOOTPRINT_BUCKETS - 1);
+    }
+
+    std::vector<std::vector<unsigned int> > buckets;
+    std::vector<Footprint> footprints;
+};
+
+// Same palette as generateBuildings(): every fifth building city-wide is a bright one
+static glm::vec3 buildingColor(CounterRng& rng, int index) {
+    float r = rng.uniform(0.2f, 0.8f);
+    float g = rng.uniform(0.2f, 0.8f);
+    float b = rng.uniform(0.2f, 0.8f);
+    if (index % 5 == 0)
+        return glm::vec3(r * 0.5f + 0.5f, g * 0.5f + 0.5f, b * 0.5f + 0.5f);
+    return glm::vec3(r * 0.3f, g * 0.3f, b * 0.5f + 0.3f);
+}
+
+// Place count buildings inside one lot, writing them to out
+static void fillLot(CounterRng& rng, FootprintHash& hash, const Footprint& lot, Building* out, int count,
+                    int firstIndex) {
+    float lotWidth = lot.maxX - lot.minX;
+    float lotDepth = lot.maxZ - lot.minZ;
+
+    // Cap footprints by each building's share of the lot, so the first box can't crowd out the rest
+    float shareSize = count ? 0.9f * std::sqrt(lotWidth * lotDepth / count) : 15.0f;
+    for (int i = 0; i < count; i++) {
+        // Draw in a fixed order, argument evaluation order is unspecified
+        Building building;
+        building.height = rng.uniform(10.0f, 60.0f);
+        building.color = buildingColor(rng, firstIndex + i);
+
+        bool placed = false;
+        float maxSize = std::min(15.0f, shareSize);
+        for (int step = 0; step < LAYOUT_SIZE_STEPS && !placed; step++, maxSize *= 0.5f) {
+            for (int attempt = 0; attempt < LAYOUT_ATTEMPTS && !placed; attempt++) {
+                float width = std::min(rng.uniform(maxSize / 3.0f, maxSize), lotWidth);
+                float depth = std::min(rng.uniform(maxSize / 3.0f, maxSize), lotDepth);
+                float x = rng.uniform(lot.minX + width * 0.5f, lot.maxX - width * 0.5f);
+                float z = rng.uniform(lot.minZ + depth * 0.5f, lot.maxZ - depth * 0.5f);
+                Footprint box = { x - width * 0.5f, z - depth * 0.5f, x + width * 0.5f, z + depth * 0.5f };
+                if (hash.overlaps(box, LAYOUT_BUILDING_GAP))
+                    continue;
+                hash.insert(box);
+                building.position = glm::vec3(x, 0.0f, z);
+                building.width = width;
+                building.depth = depth;
+                placed = true;
+            }
+        }
+
+        // No room left: a zero-sized hole at the lot center keeps the count exact
+        if (!placed) {
+            building.position = glm::vec3((lot.minX + lot.maxX) * 0.5f, 0.0f, (lot.minZ + lot.maxZ) * 0.5f);
+            building.width = building.depth = building.height = 0.0f;
+        }
+        out[i] = building;
+    }
+}
+
+// Cut a block into 1-3 by 1-3 lots and share its quota between them
+static void fillBlock(CounterRng& rng, FootprintHash& hash, float blockX, float blockZ, Building* out, int count,
+                      int firstIndex) {
+    int lotColumns = 1 + (int)(rng.next() % 3);
+    int lotRows = 1 + (int)(rng.next() % 3);
+    int lots = lotColumns * lotRows;
+    float lotWidth = LAYOUT_BLOCK_SIZE / lotColumns;
+    float lotDepth = LAYOUT_BLOCK_SIZE / lotRows;
+
+    hash.clear();
+    int placed = 0;
+    for (int lot = 0; lot < lots; lot++) {
+        int lotCount = count / lots + (lot < count % lots ? 1 : 0);
+        float x = blockX + (lot % lotColumns) * lotWidth;
+        float z = blockZ + (lot / lotColumns) * lotDepth;
+        Footprint bounds = { x + LAYOUT_LOT_SETBACK, z + LAYOUT_LOT_SETBACK,
+                             x + lotWidth - LAYOUT_LOT_SETBACK, z + lotDepth - LAYOUT_LOT_SETBACK };
+        fillLot(rng, hash, bounds, out + placed, lotCount, firstIndex + placed);
+        placed += lotCount;
+    }
+}
+
+void generateRoadCity(std::vector<Building>& buildings, int numBuildings, unsigned int seed, ThreadPool* pool,
+                      CityLayout& layout) {
+    // Square grid of just enough blocks, centered on the origin
+    int blockCount = std::max(1, (numBuildings + LAYOUT_BLOCK_BUILDINGS - 1) / LAYOUT_BLOCK_BUILDINGS);
+    layout.columns = (int)std::ceil(std::sqrt((double)blockCount));
+    layout.rows = (blockCount + layout.columns - 1) / layout.columns;
+    layout.originX = -0.5f * layout.columns * LAYOUT_BLOCK_PITCH;
+    layout.originZ = -0.5f * layout.rows * LAYOUT_BLOCK_PITCH;
+
+    // Fixed quotas give every block its slice up front, no push_back or locking
+    layout.blocks.assign((size_t)layout.columns * layout.rows, CityBlock());
+    unsigned int first = buildings.size();
+    for (int b = 0; b < blockCount; b++) {
+        layout.blocks[b].first = first;
+        layout.blocks[b].count = numBuildings / blockCount + (b < numBuildings % blockCount ? 1 : 0);
+        first += layout.blocks[b].count;
+    }
+    for (size_t b = blockCount; b < layout.blocks.size(); b++)
+        layout.blocks[b].first = first;
+
+    size_t base = buildings.size();
+    buildings.resize(base + numBuildings);
+    Building* out = buildings.data();
+    const CityLayout& blocks = layout;
+    std::function<void(size_t)> generateBlock = [=, &blocks](size_t block) {
+        const CityBlock& target = blocks.blocks[block];
+        float x = blocks.originX + (block % blocks.columns) * LAYOUT_BLOCK_PITCH + LAYOUT_ROAD_WIDTH * 0.5f;
+        float z = blocks.originZ + (block / blocks.columns) * LAYOUT_BLOCK_PITCH + LAYOUT_ROAD_WIDTH * 0.5f;
+        CounterRng rng(streamKey(seed, block));
+        FootprintHash hash;
+        fillBlock(rng, hash, x, z, out + target.first, target.count, target.first - base);
+    };
+
+    if (pool) {
+        pool->parallelFor(blockCount, generateBlock);
+    } else {
+        for (int block = 0; block < blockCount; block++)
+            generateBlock(block);
+    }
+
+    // Ground under the whole grid, roads included
+    buildings.push_back(createGround(0.0f, 0.0f, layout.columns * LAYOUT_BLOCK_PITCH + 50.0f,
+                                     layout.rows * LAYOUT_BLOCK_PITCH + 50.0f));
+}
+
+SpatialGrid layoutSpatialGrid(const CityLayout& layout, const std::vector<Building>& buildings) {
+    SpatialGrid grid;
+    grid.cellSize = LAYOUT_BLOCK_PITCH;
+    grid.originX = layout.originX;
+    grid.originZ = layout.originZ;
+    grid.columns = layout.columns;
+    grid.rows = layout.rows;
+
+    grid.cells.resize(layout.blocks.size());
+    unsigned int end = 0;
+    for (size_t c = 0; c < layout.blocks.size(); c++) {
+        GridCell& cell = grid.cells[c];
+        cell.first = layout.blocks[c].first;
+        cell.count = layout.blocks[c].count;
+        cell.boundsMin = glm::vec3(0.0f);
+        cell.boundsMax = glm::vec3(0.0f);
+        for (unsigned int i = cell.first; i < cell.first + cell.count; i++) {
+            glm::vec3 bMin, bMax;
+            buildingBounds(buildings[i], bMin, bMax);
+            cell.boundsMin = i == cell.first ? bMin : glm::min(cell.boundsMin, bMin);
+            cell.boundsMax = i == cell.first ? bMax : glm::max(cell.boundsMax, bMax);
+        }
+        end = std::max(end, cell.first + cell.count);
+    }
+
+    // Everything after the blocks (the ground) is tested on its own
+    for (unsigned int i = end; i < buildings.size(); i++) {
+        GridCell cell;
+        buildingBounds(buildings[i], cell.boundsMin, cell.boundsMax);
+        cell.first = i;
+        cell.count = 1;
+        grid.oversized.push_back(cell);
+    }
+    return grid;
+}
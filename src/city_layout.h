@@ -0,0 +1,49 @@
+#ifndef CITY_LAYOUT_H
+#define CITY_LAYOUT_H
+
+#include "city.h"
+#include "spatial_grid.h"
+
+#include <vector>
+
+class ThreadPool;
+
+// Road grid layout. Square blocks separated by roads cover the ground, each
+// block is cut into a few lots and every lot gets buildings placed by
+// rejection sampling against a spatial hash of the footprints already there,
+// so no two boxes intersect. The grid is sized from the building count, so
+// density stays the same at any scale instead of piling boxes into ±100.
+static const float LAYOUT_ROAD_WIDTH = 8.0f;
+static const float LAYOUT_BLOCK_SIZE = 56.0f; // between the roads
+static const float LAYOUT_BLOCK_PITCH = LAYOUT_BLOCK_SIZE + LAYOUT_ROAD_WIDTH;
+
+// Buildings come out grouped by block with blocks in row-major order, which
+// is the order of a SpatialGrid with one cell per block, so the block table
+// is handed to the renderer as the culling index without re-sorting.
+struct CityBlock {
+    unsigned int first;
+    unsigned int count;
+};
+
+struct CityLayout {
+    float originX; // min corner of the block grid, on a road center line
+    float originZ;
+    int columns;
+    int rows;
+    std::vector<CityBlock> blocks; // columns * rows, unused blocks in the last row are empty
+};
+
+// Append numBuildings non-overlapping buildings on a road grid, followed by a
+// ground plane under it. Every block has its own counter-based stream and a
+// fixed quota, so the output depends only on seed and numBuildings whether it
+// runs on a pool of any size or on the calling thread (pool == nullptr). A
+// building that finds no room even at the smallest size becomes a zero-sized
+// hole, so the count is always exact.
+void generateRoadCity(std::vector<Building>& buildings, int numBuildings, unsigned int seed, ThreadPool* pool,
+                      CityLayout& layout);
+
+// Grid with one cell per block (bounds from its buildings) and the ground as
+// the oversized entry; buildings must be exactly what generateRoadCity() made
+SpatialGrid layoutSpatialGrid(const CityLayout& layout, const std::vector<Building>& buildings);
+
+#endif
@@ -0,0 +1,96 @@
+#include "content_hash.h"
+#include "geometry_builder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t PRIME3 = 0x165667B19E3779F9ull;
+static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t readWord(const unsigned char* p) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+static inline uint64_t hashRound(uint64_t lane, uint64_t word) {
+    return rotl(lane + word * PRIME2, 31) * PRIME1;
+}
+
+uint64_t hashBytes(const void* data, size_t bytes, uint64_t seed) {
+    const unsigned char* p = (const unsigned char*)data;
+    const unsigned char* end = p + bytes;
+
+    // Four lanes over 32-byte stripes keep the multiplies independent
+    uint64_t hash;
+    if (bytes >= 32) {
+        uint64_t lanes[4] = { seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1 };
+        for (; p + 32 <= end; p += 32) {
+            lanes[0] = hashRound(lanes[0], readWord(p));
+            lanes[1] = hashRound(lanes[1], readWord(p + 8));
+            lanes[2] = hashRound(lanes[2], readWord(p + 16));
+            lanes[3] = hashRound(lanes[3], readWord(p + 24));
+        }
+        hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+        for (int i = 0; i < 4; i++)
+            hash = (hash ^ hashRound(0, lanes[i])) * PRIME1 + PRIME4;
+    } else {
+        hash = seed + PRIME5;
+    }
+    hash += bytes;
+
+    // Tail: whole words, then the last 0-7 bytes
+    for (; p + 8 <= end; p += 8)
+        hash = rotl(hash ^ hashRound(0, readWord(p)), 27) * PRIME1 + PRIME4;
+    for (; p < end; p++)
+        hash = rotl(hash ^ (*p * PRIME5), 11) * PRIME1;
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t hashBuildings(const std::vector<Building>& buildings) {
+    // Building is nine packed floats, no padding bytes to leak into the hash
+    return hashBytes(buildings.data(), buildings.size() * sizeof(Building), 0);
+}
+
+uint64_t hashBuildingVertices(const std::vector<Building>& buildings, bool packed,
+                              const glm::vec3& quantOrigin, const glm::vec3& quantScale) {
+    // Hash each block's bytes and chain the block hashes in order
+    GeometryBuilder builder;
+    std::vector<unsigned char> block(buildingGeometrySizes(GEOMETRY_BLOCK_BUILDINGS, packed).vertexBytes);
+    uint64_t hash = buildings.size();
+    for (size_t first = 0; first < buildings.size(); first += GEOMETRY_BLOCK_BUILDINGS) {
+        size_t n = std::min(GEOMETRY_BLOCK_BUILDINGS, buildings.size() - first);
+        bakeBuildingVertices(builder, buildings.data() + first, n, packed, quantOrigin, quantScale, block.data(), nullptr);
+        hash = hashBytes(block.data(), buildingGeometrySizes(n, packed).vertexBytes, hash);
+    }
+    return hash;
+}
+
+uint64_t hashBuildingInstances(const std::vector<Building>& buildings) {
+    std::vector<BuildingInstance> instances(buildings.size());
+    bakeBuildingInstances(buildings.data(), buildings.size(), instances.data(), nullptr);
+    return hashBytes(instances.data(), instances.size() * sizeof(BuildingInstance), 0);
+}
+
+std::string hashString(uint64_t hash) {
+    char text[19];
+    std::snprintf(text, sizeof(text), "0x%016llx", (unsigned long long)hash);
+    return text;
+}
@@ -0,0 +1,32 @@
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include "city.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Fast 64-bit content hash (xxHash64-style rounds over four independent lanes).
+// Words are read little-endian, so the same bytes hash the same on every platform.
+// Not cryptographic, meant for spotting changes in generated data.
+uint64_t hashBytes(const void* data, size_t bytes, uint64_t seed);
+
+// Hash of the Building records, in order
+uint64_t hashBuildings(const std::vector<Building>& buildings);
+
+// Hash of the vertex bytes the baked path uploads for buildings (quantized into
+// the given frame when packed), baked block by block so no full copy is held
+uint64_t hashBuildingVertices(const std::vector<Building>& buildings, bool packed,
+                              const glm::vec3& quantOrigin, const glm::vec3& quantScale);
+
+// Hash of the BuildingInstance records the instanced path uploads
+uint64_t hashBuildingInstances(const std::vector<Building>& buildings);
+
+// "0x" followed by 16 lowercase hex digits
+std::string hashString(uint64_t hash);
+
+#endif
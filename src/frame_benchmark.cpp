@@ -0,0 +1,188 @@
+#include "frame_benchmark.h"
+#include "building_mesh.h"
+#include "building_set.h"
+#include "camera_path.h"
+#include "content_hash.h"
+#include "gpu_timer.h"
+#include "profiler.h"
+#include "render_target.h"
+#include "scene.h"
+#include "thread_pool.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// ACMR and ATVR of the chunk indices before and after optimization, one entry per simulated cache size
+static void writeVertexCacheReport(std::ostream& out) {
+    out << "  \"vertex_cache\": [";
+    for (unsigned int i = 0; i < VERTEX_CACHE_REPORT_COUNT; i++) {
+        VertexCacheStats handWritten, optimized;
+        measureChunkIndices(VERTEX_CACHE_REPORT_SIZES[i], handWritten, optimized);
+        out << (i ? ", " : "") << "{\"fifo\": " << VERTEX_CACHE_REPORT_SIZES[i]
+            << ", \"acmr\": [" << handWritten.acmr << ", " << optimized.acmr << "]"
+            << ", \"atvr\": [" << handWritten.atvr << ", " << optimized.atvr << "]}";
+    }
+    out << "],\n";
+}
+
+// Quote a string for JSON output
+static std::string jsonString(const std::string& value) {
+    std::string quoted = "\"";
+    for (size_t i = 0; i < value.size(); i++) {
+        char c = value[i];
+        if (c == '"' || c == '\\')
+            quoted += '\\';
+        if ((unsigned char)c >= 0x20)
+            quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// Nearest-rank percentile of an already sorted sample
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty())
+        return 0.0;
+    size_t rank = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+static void writeDistribution(std::ostream& out, const char* name, std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (size_t i = 0; i < samples.size(); i++)
+        sum += samples[i];
+
+    out << "  \"" << name << "\": {"
+        << "\"samples\": " << samples.size()
+        << ", \"mean\": " << (samples.empty() ? 0.0 : sum / samples.size())
+        << ", \"p50\": " << percentile(samples, 50.0)
+        << ", \"p90\": " << percentile(samples, 90.0)
+        << ", \"p95\": " << percentile(samples, 95.0)
+        << ", \"p99\": " << percentile(samples, 99.0)
+        << ", \"max\": " << (samples.empty() ? 0.0 : samples.back())
+        << "}";
+}
+
+int runFrameBenchmark(const AppOptions& options, GLFWwindow* window) {
+    (void)window;
+
+    CameraPath path;
+    if (!loadCameraPath(options.cameraPath, path)) return -1;
+
+    ThreadPool pool(options.threads);
+    CityScene scene;
+    SceneTimings timings;
+    if (!createScene(options, pool, scene, timings)) return -1;
+
+    RenderTarget target = createRenderTarget(options.width, options.height);
+    if (!target.framebuffer) return -1;
+    bindRenderTarget(target);
+    float aspect = (float)options.width / (float)options.height;
+
+    GpuTimer gpuTimer = createGpuTimer(4);
+    std::vector<double> cpuFrameMs;
+    std::vector<double> gpuFrameMs;
+    std::vector<double> worldBatches;   // chunk meshes queued per frame
+    std::vector<double> worldSubmits;   // merged draws they went out as
+    std::vector<double> worldDrawCalls; // GL draw calls those took
+
+    int totalFrames = options.warmupFrames + options.frames;
+    for (int frame = 0; frame < totalFrames; frame++) {
+        bool measured = frame >= options.warmupFrames;
+        float t = options.frames > 1 ? (float)(frame - options.warmupFrames) / (options.frames - 1) : 0.0f;
+
+        glm::vec3 cameraPos, cameraFront;
+        sampleCameraPath(path, measured ? t : 0.0f, cameraPos, cameraFront);
+
+        // CPU time covers streaming, culling and command submission
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double previousGpuMs = 0.0;
+        beginProfilerFrame();
+        bool hasPrevious = beginGpuTimer(gpuTimer, previousGpuMs);
+        updateScene(scene, cameraPos);
+        renderScene(scene, cameraPos, cameraFront, aspect);
+        endGpuTimer(gpuTimer);
+        glFlush();
+        endProfilerFrame();
+        double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // The slot reused now was issued latency frames ago; drop results from warmup frames
+        if (hasPrevious && frame - (int)gpuTimer.queries.size() >= options.warmupFrames)
+            gpuFrameMs.push_back(previousGpuMs);
+        if (measured)
+            cpuFrameMs.push_back(cpuMs);
+        if (measured && options.world) {
+            worldBatches.push_back(scene.renderQueue.batches.size());
+            worldSubmits.push_back(scene.renderQueue.submits);
+            worldDrawCalls.push_back(scene.renderQueue.drawCalls);
+        }
+    }
+
+    glFinish();
+    std::vector<double> remaining;
+    flushGpuTimer(gpuTimer, remaining);
+    for (size_t i = 0; i < remaining.size() && (int)gpuFrameMs.size() < options.frames; i++)
+        gpuFrameMs.push_back(remaining[i]);
+
+    std::ofstream file;
+    if (!options.jsonOutput.empty()) {
+        file.open(options.jsonOutput.c_str());
+        if (!file) {
+            std::cerr << "ERROR::BENCHMARK::OPEN_FAILED " << options.jsonOutput << std::endl;
+            return -1;
+        }
+    }
+    std::ostream& out = options.jsonOutput.empty() ? std::cout : file;
+
+    out << "{\n"
+        << "  \"buildings\": " << (options.world ? 0 : options.numBuildings) << ",\n"
+        << "  \"seed\": " << options.seed << ",\n"
+        << "  \"mode\": \"" << (options.instanced ? "instanced" : "baked") << "\",\n"
+        << "  \"cull\": " << (options.cull ? "true" : "false") << ",\n"
+        << "  \"world\": " << (options.world ? "true" : "false") << ",\n"
+        << "  \"layout\": \"" << (options.roads ? "roads" : "scatter") << "\",\n"
+        << "  \"mesh_kernel\": \"" << buildingKernelName() << "\",\n"
+        << "  \"vertex_format\": \"" << (options.packedVertices && !options.instanced ? "packed" : "float") << "\",\n"
+        << "  \"threads\": " << pool.size() << ",\n"
+        << "  \"resolution\": [" << options.width << ", " << options.height << "],\n"
+        << "  \"camera_path\": " << jsonString(options.cameraPath) << ",\n"
+        << "  \"frames\": " << options.frames << ",\n"
+        << "  \"startup_ms\": {"
+        << "\"generation\": " << timings.generationMs
+        << ", \"index\": " << timings.indexMs
+        << ", \"mesh\": " << timings.meshMs
+        << ", \"upload\": " << timings.uploadMs << "},\n"
+        << "  \"geometry_mb\": " << timings.geometryBytes / (1024.0 * 1024.0) << ",\n"
+        << "  \"startup_peak_rss_mb\": " << timings.peakResidentBytes / (1024.0 * 1024.0) << ",\n";
+    writeVertexCacheReport(out);
+    if (options.hash) {
+        uint64_t buildingsHash, geometryHash;
+        hashScene(scene, buildingsHash, geometryHash);
+        out << "  \"content_hash\": {\"buildings\": \"" << hashString(buildingsHash)
+            << "\", \"geometry\": \"" << hashString(geometryHash) << "\"},\n";
+    }
+    writeDistribution(out, "cpu_frame_ms", cpuFrameMs);
+    out << ",\n";
+    writeDistribution(out, "gpu_frame_ms", gpuFrameMs);
+    if (options.world) {
+        // Flat submits as the batch count grows show the render queue merging chunks
+        out << ",\n";
+        writeDistribution(out, "world_batches", worldBatches);
+        out << ",\n";
+        writeDistribution(out, "world_submits", worldSubmits);
+        out << ",\n";
+        writeDistribution(out, "world_draw_calls", worldDrawCalls);
+    }
+    out << "\n}\n";
+
+    destroyGpuTimer(gpuTimer);
+    destroyRenderTarget(target);
+    destroyScene(scene);
+    return 0;
+}
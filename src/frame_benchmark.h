@@ -0,0 +1,13 @@
+#ifndef FRAME_BENCHMARK_H
+#define FRAME_BENCHMARK_H
+
+#include "options.h"
+
+#include <GLFW/glfw3.h>
+
+// Build the scene, render options.frames frames along options.cameraPath into
+// an offscreen target and print startup and per-frame timings as JSON.
+// window only provides the (hidden) GL context. Returns the process exit code.
+int runFrameBenchmark(const AppOptions& options, GLFWwindow* window);
+
+#endif
@@ -0,0 +1,50 @@
+#include "frame_cache.h"
+
+#include <glad/glad.h>
+
+FrameCache createFrameCache() {
+    FrameCache cache;
+    cache.target = RenderTarget();
+    cache.state = FrameState();
+    cache.valid = false;
+    return cache;
+}
+
+bool frameUnchanged(const FrameCache& cache, const FrameState& state) {
+    return cache.valid && cache.state.cameraPos == state.cameraPos && cache.state.cameraFront == state.cameraFront &&
+           cache.state.width == state.width && cache.state.height == state.height &&
+           cache.state.sceneRevision == state.sceneRevision;
+}
+
+bool beginCachedFrame(FrameCache& cache, const FrameState& state) {
+    cache.valid = false;
+    if (state.width <= 0 || state.height <= 0)
+        return false;
+
+    // A size the driver rejected stays rejected until the window is resized
+    if (cache.target.width != state.width || cache.target.height != state.height) {
+        destroyRenderTarget(cache.target);
+        cache.target = createRenderTarget(state.width, state.height);
+    }
+    if (!cache.target.framebuffer)
+        return false;
+
+    bindRenderTarget(cache.target);
+    cache.state = state;
+    cache.valid = true;
+    return true;
+}
+
+void presentCachedFrame(const FrameCache& cache) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, cache.target.framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, cache.target.width, cache.target.height, 0, 0, cache.target.width, cache.target.height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void destroyFrameCache(FrameCache& cache) {
+    if (cache.target.framebuffer)
+        destroyRenderTarget(cache.target);
+    cache.valid = false;
+}
@@ -0,0 +1,42 @@
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include "render_target.h"
+
+#include <glm/glm.hpp>
+
+// Everything that decides what a frame shows; two frames with equal state
+// draw the same image
+struct FrameState {
+    glm::vec3 cameraPos;
+    glm::vec3 cameraFront;
+    int width;
+    int height;
+    unsigned int sceneRevision;
+};
+
+// The last drawn frame kept in an offscreen target, so an idle window can be
+// presented again (after an expose, once the back buffer is undefined) with
+// one blit instead of redrawing the city
+struct FrameCache {
+    RenderTarget target;
+    FrameState state;
+    bool valid;
+};
+
+FrameCache createFrameCache();
+
+// True when a frame of state would reproduce the cached image
+bool frameUnchanged(const FrameCache& cache, const FrameState& state);
+
+// Bind the offscreen target for drawing a frame of state, resizing it to
+// match. Returns false (nothing bound) if the target can't be created, the
+// caller then draws straight into the window.
+bool beginCachedFrame(FrameCache& cache, const FrameState& state);
+
+// Copy the cached image into the window's back buffer and leave it bound
+void presentCachedFrame(const FrameCache& cache);
+
+void destroyFrameCache(FrameCache& cache);
+
+#endif
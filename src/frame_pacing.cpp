@@ -0,0 +1,46 @@
+#include "frame_pacing.h"
+
+#include <GLFW/glfw3.h>
+
+#include <thread>
+
+typedef std::chrono::steady_clock Clock;
+
+// Longest time step handed to movement
+static const float MAX_FRAME_SECONDS = 0.1f;
+
+// The OS sleep overshoots by up to a scheduler tick, the rest is spent yielding
+static const std::chrono::microseconds SLEEP_MARGIN(1500);
+
+void initFramePacer(FramePacer& pacer, bool vsync, float targetFps) {
+    glfwSwapInterval(vsync ? 1 : 0);
+    pacer.interval = targetFps > 0.0f ? std::chrono::duration_cast<Clock::duration>(
+                                            std::chrono::duration<double>(1.0 / targetFps))
+                                      : Clock::duration::zero();
+    pacer.lastFrame = Clock::now();
+    pacer.deadline = pacer.lastFrame;
+}
+
+float beginPacedFrame(FramePacer& pacer) {
+    Clock::time_point now = Clock::now();
+    float deltaTime = std::chrono::duration<float>(now - pacer.lastFrame).count();
+    pacer.lastFrame = now;
+    return deltaTime < MAX_FRAME_SECONDS ? deltaTime : MAX_FRAME_SECONDS;
+}
+
+void waitForNextFrame(FramePacer& pacer) {
+    Clock::duration interval = pacer.interval;
+    if (interval == Clock::duration::zero())
+        return;
+    Clock::time_point now = Clock::now();
+
+    // Deadlines advance by whole intervals so the average rate holds, but a
+    // frame that ran more than an interval late restarts the schedule
+    pacer.deadline += interval;
+    if (now - pacer.deadline > interval)
+        pacer.deadline = now;
+    if (pacer.deadline - now > SLEEP_MARGIN)
+        std::this_thread::sleep_until(pacer.deadline - SLEEP_MARGIN);
+    while (Clock::now() < pacer.deadline)
+        std::this_thread::yield();
+}
@@ -0,0 +1,24 @@
+#ifndef FRAME_PACING_H
+#define FRAME_PACING_H
+
+#include <chrono>
+
+// Frame pacing for the interactive loop: the swap interval, an optional
+// sleep-based frame rate cap and the scaled time step for camera movement.
+struct FramePacer {
+    std::chrono::steady_clock::duration interval; // zero when uncapped
+    std::chrono::steady_clock::time_point deadline;
+    std::chrono::steady_clock::time_point lastFrame;
+};
+
+// Sets the swap interval of the current context; targetFps 0 leaves the rate to vsync
+void initFramePacer(FramePacer& pacer, bool vsync, float targetFps);
+
+// Seconds since the previous call, clamped so a stall or an idle stretch
+// doesn't move the camera by a huge step
+float beginPacedFrame(FramePacer& pacer);
+
+// Sleep until the next frame is due under the cap, returns at once when uncapped
+void waitForNextFrame(FramePacer& pacer);
+
+#endif
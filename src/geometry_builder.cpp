@@ -0,0 +1,123 @@
+#include "geometry_builder.h"
+#include "building_mesh.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+GeometrySizes buildingGeometrySizes(size_t buildingCount, bool packed) {
+    GeometrySizes sizes;
+    sizes.vertexCount = buildingCount * 8;
+    sizes.vertexBytes = sizes.vertexCount * (packed ? sizeof(PackedBuildingVertex) : 6 * sizeof(float));
+    sizes.indexCount = buildingCount * 36;
+    sizes.instanceBytes = buildingCount * sizeof(BuildingInstance);
+    return sizes;
+}
+
+// Bake [first, first + count) block by block; out addresses building 0
+static void bakeVertexRange(GeometryBuilder& builder, const Building* buildings, size_t first, size_t count,
+                            bool packed, const glm::vec3& quantOrigin, const glm::vec3& quantScale, void* out) {
+    if (packed)
+        builder.staging.resize(std::min(count, GEOMETRY_BLOCK_BUILDINGS) * 48);
+
+    size_t end = first + count;
+    for (; first < end; first += GEOMETRY_BLOCK_BUILDINGS) {
+        size_t n = std::min(GEOMETRY_BLOCK_BUILDINGS, end - first);
+        toBuildingSet(buildings + first, n, builder.set);
+
+        if (packed) {
+            // Quantize from the float staging block, the destination is never read
+            createBuildingBuffers(builder.set, builder.staging.data(), nullptr, 0);
+            packBuildingVertices(builder.staging.data(), n * 8, quantOrigin, quantScale,
+                                 (PackedBuildingVertex*)out + first * 8);
+        } else {
+            createBuildingBuffers(builder.set, (float*)out + first * 48, nullptr, 0);
+        }
+    }
+}
+
+void forEachBuildingRange(size_t count, ThreadPool* pool, const std::function<void(size_t, size_t)>& job) {
+    size_t blockCount = (count + GEOMETRY_BLOCK_BUILDINGS - 1) / GEOMETRY_BLOCK_BUILDINGS;
+    size_t rangeCount = pool ? std::min(blockCount, (size_t)pool->size() + 1) : 1;
+    if (rangeCount <= 1) {
+        job(0, count);
+        return;
+    }
+
+    // Whole blocks per range, the first blockCount % rangeCount ranges take one extra
+    pool->parallelFor(rangeCount, [&](size_t range) {
+        size_t blocks = blockCount / rangeCount, extra = blockCount % rangeCount;
+        size_t firstBlock = range * blocks + std::min(range, extra);
+        size_t first = firstBlock * GEOMETRY_BLOCK_BUILDINGS;
+        size_t end = std::min(count, (firstBlock + blocks + (range < extra ? 1 : 0)) * GEOMETRY_BLOCK_BUILDINGS);
+        job(first, end - first);
+    });
+}
+
+void bakeBuildingVertices(GeometryBuilder& builder, const Building* buildings, size_t count, bool packed,
+                          const glm::vec3& quantOrigin, const glm::vec3& quantScale, void* out,
+                          ThreadPool* pool) {
+    if (!pool) {
+        bakeVertexRange(builder, buildings, 0, count, packed, quantOrigin, quantScale, out);
+        return;
+    }
+
+    // Ranges never overlap and their offsets are known from the counts, no locking
+    forEachBuildingRange(count, pool, [&](size_t first, size_t n) {
+        GeometryBuilder rangeBuilder;
+        bakeVertexRange(rangeBuilder, buildings, first, n, packed, quantOrigin, quantScale, out);
+    });
+}
+
+void bakeBuildingInstances(const Building* buildings, size_t count, BuildingInstance* out, ThreadPool* pool) {
+    forEachBuildingRange(count, pool, [&](size_t first, size_t n) {
+        for (size_t i = first; i < first + n; i++) {
+            const Building& b = buildings[i];
+            BuildingInstance inst;
+            inst.offset[0] = b.position.x; inst.offset[1] = b.position.y; inst.offset[2] = b.position.z;
+            inst.scale[0] = b.width; inst.scale[1] = b.height; inst.scale[2] = b.depth;
+            inst.color[0] = b.color.r; inst.color[1] = b.color.g; inst.color[2] = b.color.b;
+            out[i] = inst;
+        }
+    });
+}
+
+void buildingVertexBounds(const Building* buildings, size_t count, glm::vec3& boundsMin, glm::vec3& boundsMax) {
+    boundsMin = glm::vec3(0.0f);
+    boundsMax = glm::vec3(0.0f);
+    for (size_t i = 0; i < count; i++) {
+        glm::vec3 bMin, bMax;
+        buildingBounds(buildings[i], bMin, bMax);
+        boundsMin = i ? glm::min(boundsMin, bMin) : bMin;
+        boundsMax = i ? glm::max(boundsMax, bMax) : bMax;
+    }
+}
+
+size_t geometryBuilderBytes(const GeometryBuilder& builder) {
+    return (builder.set.x.capacity() * 9 + builder.staging.capacity()) * sizeof(float);
+}
+
+size_t peakResidentBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(__APPLE__)
+    return (size_t)usage.ru_maxrss;        // bytes
+#else
+    return (size_t)usage.ru_maxrss * 1024; // kilobytes
+#endif
+#endif
+}
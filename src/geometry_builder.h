@@ -0,0 +1,63 @@
+#ifndef GEOMETRY_BUILDER_H
+#define GEOMETRY_BUILDER_H
+
+#include "building_set.h"
+#include "city.h"
+#include "instancing.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class ThreadPool;
+
+// Buildings baked per block, bounds the builder's scratch memory
+static const size_t GEOMETRY_BLOCK_BUILDINGS = 4096;
+
+// Exact output sizes for a building count, known before anything is built
+struct GeometrySizes {
+    size_t vertexCount;   // 8 per building
+    size_t vertexBytes;   // 24 bytes per vertex, 12 when packed
+    size_t indexCount;    // 36 per building (32-bit kernel output)
+    size_t instanceBytes; // one BuildingInstance per building
+};
+
+GeometrySizes buildingGeometrySizes(size_t buildingCount, bool packed);
+
+// Reusable block scratch: the SoA copy the SIMD kernel reads and, for packed
+// output, the float vertices it writes before quantization. Its size depends
+// only on GEOMETRY_BLOCK_BUILDINGS, never on the city.
+struct GeometryBuilder {
+    BuildingSet set;
+    std::vector<float> staging;
+};
+
+// Bake buildings block by block into out, which must hold
+// buildingGeometrySizes(count, packed).vertexBytes. out can be a mapped GL
+// buffer: it is only ever written. With a pool the blocks are split into one
+// contiguous range per thread, each with its own scratch, and every range
+// writes to its precomputed offset; the output is identical either way.
+// builder is only used on the calling thread (pool == nullptr).
+void bakeBuildingVertices(GeometryBuilder& builder, const Building* buildings, size_t count, bool packed,
+                          const glm::vec3& quantOrigin, const glm::vec3& quantScale, void* out,
+                          ThreadPool* pool);
+
+// Write one BuildingInstance per building into out, same rules as above
+void bakeBuildingInstances(const Building* buildings, size_t count, BuildingInstance* out, ThreadPool* pool);
+
+// Split count buildings into at most one block-aligned range per pool thread
+// (plus the caller) and run job(first, n) for each, serially without a pool
+void forEachBuildingRange(size_t count, ThreadPool* pool, const std::function<void(size_t, size_t)>& job);
+
+// Bounds of the baked vertices, the quantization frame of a packed mesh
+void buildingVertexBounds(const Building* buildings, size_t count, glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+// Bytes of scratch the builder holds
+size_t geometryBuilderBytes(const GeometryBuilder& builder);
+
+// Peak resident set size of the process so far, 0 where unsupported
+size_t peakResidentBytes();
+
+#endif
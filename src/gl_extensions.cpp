@@ -0,0 +1,74 @@
+#include "gl_extensions.h"
+
+#include <GLFW/glfw3.h>
+
+#include <cstddef>
+
+GLExtensions glExtensions = GLExtensions();
+
+#ifndef GL_VERSION_4_4
+PFNGLBUFFERSTORAGEPROC ext_glBufferStorage = NULL;
+#endif
+#ifndef GL_VERSION_4_1
+PFNGLGETPROGRAMBINARYPROC ext_glGetProgramBinary = NULL;
+PFNGLPROGRAMBINARYPROC ext_glProgramBinary = NULL;
+PFNGLPROGRAMPARAMETERIPROC ext_glProgramParameteri = NULL;
+#endif
+#ifndef GL_VERSION_4_2
+PFNGLMEMORYBARRIERPROC ext_glMemoryBarrier = NULL;
+#endif
+#ifndef GL_VERSION_4_3
+PFNGLDISPATCHCOMPUTEPROC ext_glDispatchCompute = NULL;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC ext_glMultiDrawElementsIndirect = NULL;
+#endif
+
+static bool hasVersion(int major, int minor) {
+    return glExtensions.major > major || (glExtensions.major == major && glExtensions.minor >= minor);
+}
+
+void loadGLExtensions() {
+    glExtensions.major = GLVersion.major;
+    glExtensions.minor = GLVersion.minor;
+
+#ifndef GL_VERSION_4_4
+    if (hasVersion(4, 4) || glfwExtensionSupported("GL_ARB_buffer_storage"))
+        ext_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+    glExtensions.bufferStorage = ext_glBufferStorage != NULL;
+#else
+    glExtensions.bufferStorage = hasVersion(4, 4) || glfwExtensionSupported("GL_ARB_buffer_storage");
+#endif
+
+    // A driver may expose the entry points but no formats, which makes binaries useless
+    bool programBinary = hasVersion(4, 1) || glfwExtensionSupported("GL_ARB_get_program_binary");
+#ifndef GL_VERSION_4_1
+    if (programBinary) {
+        ext_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)glfwGetProcAddress("glGetProgramBinary");
+        ext_glProgramBinary = (PFNGLPROGRAMBINARYPROC)glfwGetProcAddress("glProgramBinary");
+        ext_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)glfwGetProcAddress("glProgramParameteri");
+    }
+    programBinary = programBinary && ext_glGetProgramBinary != NULL && ext_glProgramBinary != NULL &&
+                    ext_glProgramParameteri != NULL;
+#endif
+    if (programBinary) {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        programBinary = formats > 0;
+    }
+    glExtensions.programBinary = programBinary;
+
+    glExtensions.computeCulling = hasVersion(4, 3);
+#ifndef GL_VERSION_4_2
+    if (hasVersion(4, 3))
+        ext_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)glfwGetProcAddress("glMemoryBarrier");
+    glExtensions.computeCulling = glExtensions.computeCulling && ext_glMemoryBarrier != NULL;
+#endif
+#ifndef GL_VERSION_4_3
+    if (hasVersion(4, 3)) {
+        ext_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)glfwGetProcAddress("glDispatchCompute");
+        ext_glMultiDrawElementsIndirect =
+            (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)glfwGetProcAddress("glMultiDrawElementsIndirect");
+    }
+    glExtensions.computeCulling = glExtensions.computeCulling && ext_glDispatchCompute != NULL &&
+                                  ext_glMultiDrawElementsIndirect != NULL;
+#endif
+}
@@ -0,0 +1,76 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+// glad was generated for the GL 3.3 core profile only. Newer entry points used
+// by optional fast paths are loaded here at runtime and every caller must check
+// the matching flag in glExtensions before using them. Regenerating glad with a
+// newer version defines GL_VERSION_4_x and these declarations step aside.
+
+// Capabilities of the current context
+struct GLExtensions {
+    int major;
+    int minor;
+    bool bufferStorage; // GL 4.4 or GL_ARB_buffer_storage
+    bool computeCulling; // GL 4.3: compute shaders, SSBOs and glMultiDrawElementsIndirect
+    bool programBinary;  // GL 4.1 or GL_ARB_get_program_binary, with at least one binary format
+};
+
+extern GLExtensions glExtensions;
+
+// Fill glExtensions and load the entry points, call once after gladLoadGLLoader()
+void loadGLExtensions();
+
+#ifndef GL_VERSION_4_4
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+extern PFNGLBUFFERSTORAGEPROC ext_glBufferStorage;
+#define glBufferStorage ext_glBufferStorage
+#endif
+
+#ifndef GL_VERSION_4_0
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+#ifndef GL_VERSION_4_1
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length,
+                                                   GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+extern PFNGLGETPROGRAMBINARYPROC ext_glGetProgramBinary;
+extern PFNGLPROGRAMBINARYPROC ext_glProgramBinary;
+extern PFNGLPROGRAMPARAMETERIPROC ext_glProgramParameteri;
+#define glGetProgramBinary ext_glGetProgramBinary
+#define glProgramBinary ext_glProgramBinary
+#define glProgramParameteri ext_glProgramParameteri
+#endif
+
+#ifndef GL_VERSION_4_2
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+extern PFNGLMEMORYBARRIERPROC ext_glMemoryBarrier;
+#define glMemoryBarrier ext_glMemoryBarrier
+#endif
+
+#ifndef GL_VERSION_4_3
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#define GL_COMPUTE_SHADER 0x91B9
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint numGroupsX, GLuint numGroupsY, GLuint numGroupsZ);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect,
+                                                            GLsizei drawCount, GLsizei stride);
+extern PFNGLDISPATCHCOMPUTEPROC ext_glDispatchCompute;
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC ext_glMultiDrawElementsIndirect;
+#define glDispatchCompute ext_glDispatchCompute
+#define glMultiDrawElementsIndirect ext_glMultiDrawElementsIndirect
+#endif
+
+#endif
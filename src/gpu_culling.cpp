@@ -0,0 +1,161 @@
+#include "gpu_culling.h"
+#include "gl_extensions.h"
+#include "shaders.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+static const unsigned int CULL_GROUP_SIZE = 64;
+
+static bool compileCuller(GpuCuller& culler, const char* source) {
+    culler.program = compileComputeProgram(source);
+    if (!culler.program) {
+        std::cerr << "ERROR::GPU_CULLING::PROGRAM_FAILED" << std::endl;
+        return false;
+    }
+    culler.itemCountLoc = glGetUniformLocation(culler.program, "itemCount");
+    return true;
+}
+
+GpuCuller createGpuCuller(const InstancedMesh& mesh) {
+    GpuCuller culler = GpuCuller();
+    culler.instanced = true;
+    culler.itemCount = mesh.instanceCount;
+    if (!compileCuller(culler, cullInstancesComputeSource))
+        return culler;
+
+    // The instance VBO doubles as the shader's input
+    culler.sourceBuffer = mesh.instanceVBO;
+
+    glGenBuffers(1, &culler.visibleBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, culler.visibleBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (size_t)culler.itemCount * sizeof(BuildingInstance), NULL, GL_DYNAMIC_COPY);
+
+    DrawElementsIndirectCommand command = { mesh.indexCount, 0, 0, 0, 0 };
+    glGenBuffers(1, &culler.commandBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler.commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(command), &command, GL_DYNAMIC_DRAW);
+
+    // Same cube as the mesh, instance attributes read from the compacted buffer
+    glGenVertexArrays(1, &culler.VAO);
+    glBindVertexArray(culler.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.cubeVBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.cubeEBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, culler.visibleBuffer);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(BuildingInstance), (void*)offsetof(BuildingInstance, offset));
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(BuildingInstance), (void*)offsetof(BuildingInstance, scale));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(BuildingInstance), (void*)offsetof(BuildingInstance, color));
+    for (unsigned int attribute = 1; attribute <= 3; attribute++) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    glBindVertexArray(0);
+
+    return culler;
+}
+
+static void appendCell(const GridCell& cell, std::vector<float>& bounds, std::vector<DrawElementsIndirectCommand>& commands) {
+    float cellBounds[8] = { cell.boundsMin.x, cell.boundsMin.y, cell.boundsMin.z, 0.0f,
+                            cell.boundsMax.x, cell.boundsMax.y, cell.boundsMax.z, 0.0f };
+
+    // One command per 16-bit index chunk the cell touches, as in drawBuildingMeshRanges()
+    unsigned int first = cell.first;
+    unsigned int remaining = cell.count;
+    while (remaining) {
+        unsigned int local = first % MESH_CHUNK_BUILDINGS;
+        unsigned int count = std::min(remaining, MESH_CHUNK_BUILDINGS - local);
+        DrawElementsIndirectCommand command = { count * SURFACE_CUBE_INDICES, 0, local * SURFACE_CUBE_INDICES,
+                                                (first / MESH_CHUNK_BUILDINGS) * MESH_CHUNK_VERTICES, 0 };
+        commands.push_back(command);
+        bounds.insert(bounds.end(), cellBounds, cellBounds + 8);
+        first += count;
+        remaining -= count;
+    }
+}
+
+GpuCuller createGpuCuller(const SpatialGrid& grid) {
+    GpuCuller culler = GpuCuller();
+    culler.instanced = false;
+    if (!compileCuller(culler, cullCellsComputeSource))
+        return culler;
+
+    std::vector<float> bounds;
+    std::vector<DrawElementsIndirectCommand> commands;
+    for (size_t c = 0; c < grid.cells.size(); c++) {
+        if (grid.cells[c].count)
+            appendCell(grid.cells[c], bounds, commands);
+    }
+    for (size_t c = 0; c < grid.oversized.size(); c++)
+        appendCell(grid.oversized[c], bounds, commands);
+    culler.itemCount = commands.size();
+
+    glGenBuffers(1, &culler.sourceBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culler.sourceBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bounds.size() * sizeof(float), bounds.data(), GL_STATIC_DRAW);
+
+    glGenBuffers(1, &culler.commandBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler.commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand),
+                 commands.data(), GL_DYNAMIC_DRAW);
+
+    return culler;
+}
+
+void runGpuCuller(const GpuCuller& culler) {
+    if (!culler.itemCount)
+        return;
+
+    // Restart the compacted instance count
+    if (culler.instanced) {
+        unsigned int zero = 0;
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler.commandBuffer);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, offsetof(DrawElementsIndirectCommand, instanceCount), sizeof(zero), &zero);
+    }
+
+    glUseProgram(culler.program);
+    glUniform1ui(culler.itemCountLoc, culler.itemCount);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, culler.sourceBuffer);
+    if (culler.instanced)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, culler.visibleBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, culler.commandBuffer);
+
+    glDispatchCompute((culler.itemCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    // Commands and compacted attributes are consumed by the next draw
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void drawGpuCulled(const GpuCuller& culler, const BuildingMesh& mesh) {
+    if (!culler.itemCount)
+        return;
+
+    if (!culler.instanced)
+        bindBuildingMeshUniforms(mesh);
+    glBindVertexArray(culler.instanced ? culler.VAO : mesh.VAO);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler.commandBuffer);
+    if (culler.instanced)
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, 1, 0);
+    else
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, 0, culler.itemCount, 0);
+}
+
+void destroyGpuCuller(GpuCuller& culler) {
+    if (culler.program)
+        glDeleteProgram(culler.program);
+    glDeleteBuffers(1, &culler.commandBuffer);
+    if (culler.instanced) {
+        // sourceBuffer belongs to the instanced mesh
+        glDeleteBuffers(1, &culler.visibleBuffer);
+        glDeleteVertexArrays(1, &culler.VAO);
+    } else {
+        glDeleteBuffers(1, &culler.sourceBuffer);
+    }
+    culler = GpuCuller();
+}
@@ -0,0 +1,49 @@
+#ifndef GPU_CULLING_H
+#define GPU_CULLING_H
+
+#include "building_mesh.h"
+#include "instancing.h"
+#include "spatial_grid.h"
+
+// GPU-driven frustum culling (GL 4.3, check glExtensions.computeCulling).
+// The instanced path culls every building in a compute shader and compacts the
+// survivors into a buffer drawn by one indirect command. The baked path keeps
+// one indirect command per grid cell (split at 16-bit index chunks) and the
+// shader only toggles its instanceCount, so the CPU never walks buildings or
+// cells per frame.
+struct GpuCuller {
+    bool instanced;
+    unsigned int program;
+    int itemCountLoc;
+    unsigned int itemCount;      // buildings (instanced) or cell pieces per index chunk (baked)
+    unsigned int sourceBuffer;   // instance records or cell bounds, read as an SSBO
+    unsigned int commandBuffer;  // DrawElementsIndirectCommand records
+    unsigned int visibleBuffer;  // instanced only: compacted instance records
+    unsigned int VAO;            // instanced only: shared cube plus visibleBuffer attributes
+};
+
+// Layout of one glMultiDrawElementsIndirect record
+struct DrawElementsIndirectCommand {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    unsigned int baseVertex;
+    unsigned int baseInstance;
+};
+
+// Cull the instances of mesh, returns a culler with program 0 on failure
+GpuCuller createGpuCuller(const InstancedMesh& mesh);
+
+// Cull the grid cells of a baked mesh built in grid order
+GpuCuller createGpuCuller(const SpatialGrid& grid);
+
+// Dispatch the culling shader against the frustum planes in this frame's FrameUniforms
+void runGpuCuller(const GpuCuller& culler);
+
+// Draw what survived with glMultiDrawElementsIndirect. mesh is only used by the
+// baked path, which draws from its VAO; the building program must be bound.
+void drawGpuCulled(const GpuCuller& culler, const BuildingMesh& mesh);
+
+void destroyGpuCuller(GpuCuller& culler);
+
+#endif
@@ -0,0 +1,49 @@
+#include "gpu_timer.h"
+
+#include <glad/glad.h>
+
+static double readQueryMs(unsigned int query) {
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+    return nanoseconds / 1.0e6;
+}
+
+GpuTimer createGpuTimer(size_t latency) {
+    GpuTimer timer;
+    timer.queries.resize(latency < 2 ? 2 : latency);
+    timer.issued.assign(timer.queries.size(), false);
+    timer.next = 0;
+    glGenQueries(timer.queries.size(), timer.queries.data());
+    return timer;
+}
+
+bool beginGpuTimer(GpuTimer& timer, double& previousMs) {
+    bool hasPrevious = timer.issued[timer.next];
+    if (hasPrevious)
+        previousMs = readQueryMs(timer.queries[timer.next]);
+
+    glBeginQuery(GL_TIME_ELAPSED, timer.queries[timer.next]);
+    timer.issued[timer.next] = true;
+    return hasPrevious;
+}
+
+void endGpuTimer(GpuTimer& timer) {
+    glEndQuery(GL_TIME_ELAPSED);
+    timer.next = (timer.next + 1) % timer.queries.size();
+}
+
+void flushGpuTimer(GpuTimer& timer, std::vector<double>& results) {
+    for (size_t i = 0; i < timer.queries.size(); i++) {
+        size_t slot = (timer.next + i) % timer.queries.size();
+        if (timer.issued[slot]) {
+            results.push_back(readQueryMs(timer.queries[slot]));
+            timer.issued[slot] = false;
+        }
+    }
+}
+
+void destroyGpuTimer(GpuTimer& timer) {
+    glDeleteQueries(timer.queries.size(), timer.queries.data());
+    timer.queries.clear();
+    timer.issued.clear();
+}
@@ -0,0 +1,28 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <cstddef>
+#include <vector>
+
+// Ring of GL_TIME_ELAPSED queries. A slot is only read back when it comes
+// around again, latency frames later, so reading never stalls the pipeline.
+struct GpuTimer {
+    std::vector<unsigned int> queries;
+    std::vector<bool> issued;
+    size_t next;
+};
+
+GpuTimer createGpuTimer(size_t latency);
+
+// Start timing into the next slot. If that slot still holds an older result it
+// is read first and returned through previousMs.
+bool beginGpuTimer(GpuTimer& timer, double& previousMs);
+
+void endGpuTimer(GpuTimer& timer);
+
+// Read back every outstanding result, oldest first
+void flushGpuTimer(GpuTimer& timer, std::vector<double>& results);
+
+void destroyGpuTimer(GpuTimer& timer);
+
+#endif
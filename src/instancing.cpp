@@ -0,0 +1,186 @@
+#include "instancing.h"
+#include "geometry_builder.h"
+#include "vertex_cache.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstddef>
+
+// Point the instance attributes at record firstInstance of the bound instance buffer
+static void bindInstanceAttributes(size_t firstInstance) {
+    size_t base = firstInstance * sizeof(BuildingInstance);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(BuildingInstance), (void*)(base + offsetof(BuildingInstance, offset)));
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(BuildingInstance), (void*)(base + offsetof(BuildingInstance, scale)));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(BuildingInstance), (void*)(base + offsetof(BuildingInstance, color)));
+}
+
+void createUnitCube(std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+    // Bottom vertices (front-left, front-right, back-right, back-left), then top vertices
+    static const float cubeVertices[] = {
+        -0.5f, -0.5f,  0.5f,
+         0.5f, -0.5f,  0.5f,
+         0.5f, -0.5f, -0.5f,
+        -0.5f, -0.5f, -0.5f,
+        -0.5f,  0.5f,  0.5f,
+         0.5f,  0.5f,  0.5f,
+         0.5f,  0.5f, -0.5f,
+        -0.5f,  0.5f, -0.5f
+    };
+
+    // Bottom, top, front, right, back, left
+    static const unsigned int cubeIndices[] = {
+        0, 1, 2,  2, 3, 0,
+        4, 7, 6,  6, 5, 4,
+        0, 4, 5,  5, 1, 0,
+        1, 5, 6,  6, 2, 1,
+        2, 6, 7,  7, 3, 2,
+        3, 7, 4,  4, 0, 3
+    };
+
+    vertices.assign(cubeVertices, cubeVertices + sizeof(cubeVertices) / sizeof(float));
+    indices.assign(cubeIndices, cubeIndices + sizeof(cubeIndices) / sizeof(unsigned int));
+}
+
+void createSurfaceCubeIndices(std::vector<unsigned int>& indices) {
+    std::vector<float> cubeVertices;
+    createUnitCube(cubeVertices, indices);
+    indices.erase(indices.begin(), indices.end() - SURFACE_CUBE_INDICES);
+    optimizeVertexCache(indices.data(), indices.size(), cubeVertices.size() / 3);
+}
+
+void createInstanceData(const std::vector<Building>& buildings, std::vector<BuildingInstance>& instances,
+                        ThreadPool* pool) {
+    instances.resize(buildings.size());
+    bakeBuildingInstances(buildings.data(), buildings.size(), instances.data(), pool);
+}
+
+InstancedMesh createInstancedMesh(const std::vector<Building>& buildings, StreamBuffer* stream, ThreadPool* pool) {
+    std::vector<BuildingInstance> instances;
+    if (stream || buildings.empty()) {
+        createInstanceData(buildings, instances, pool);
+        return createInstancedMesh(instances.data(), instances.size(), stream);
+    }
+
+    // Allocate only, then write the records straight into the mapped instance buffer
+    InstancedMesh mesh = createInstancedMesh(nullptr, buildings.size(), nullptr);
+    size_t bytes = buildings.size() * sizeof(BuildingInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.instanceVBO);
+    void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped) {
+        bakeBuildingInstances(buildings.data(), buildings.size(), (BuildingInstance*)mapped, pool);
+        if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE)
+            return mesh;
+    }
+
+    // Mapping failed or its contents were lost
+    createInstanceData(buildings, instances, pool);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instances.data());
+    return mesh;
+}
+
+InstancedMesh createInstancedMesh(const BuildingInstance* instances, size_t instanceCount, StreamBuffer* stream) {
+    std::vector<float> cubeVertices;
+    std::vector<unsigned int> cubeIndices;
+    createUnitCube(cubeVertices, cubeIndices);
+    createSurfaceCubeIndices(cubeIndices);
+
+    InstancedMesh mesh;
+    mesh.indexCount = cubeIndices.size();
+    mesh.instanceCount = instanceCount;
+
+    glGenVertexArrays(1, &mesh.VAO);
+    glGenBuffers(1, &mesh.cubeVBO);
+    glGenBuffers(1, &mesh.cubeEBO);
+    glGenBuffers(1, &mesh.instanceVBO);
+
+    glBindVertexArray(mesh.VAO);
+
+    // Shared cube geometry
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.cubeVBO);
+    glBufferData(GL_ARRAY_BUFFER, cubeVertices.size() * sizeof(float), cubeVertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.cubeEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, cubeIndices.size() * sizeof(unsigned int), cubeIndices.data(), GL_STATIC_DRAW);
+
+    // Position attribute
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Per-instance offset, scale and color, advanced once per building
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.instanceVBO);
+    if (stream) {
+        glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(BuildingInstance), NULL, GL_STATIC_DRAW);
+        streamUpload(*stream, mesh.instanceVBO, 0, instances, instanceCount * sizeof(BuildingInstance));
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(BuildingInstance), instances, GL_STATIC_DRAW);
+    }
+
+    bindInstanceAttributes(0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+
+    glBindVertexArray(0);
+
+    return mesh;
+}
+
+void updateInstancedMesh(InstancedMesh& mesh, StreamBuffer& stream, unsigned int first,
+                         const Building* buildings, unsigned int count) {
+    std::vector<BuildingInstance> instances(count);
+    bakeBuildingInstances(buildings, count, instances.data(), nullptr);
+    streamUpload(stream, mesh.instanceVBO, (size_t)first * sizeof(BuildingInstance),
+                 instances.data(), instances.size() * sizeof(BuildingInstance));
+}
+
+void resizeInstancedMesh(InstancedMesh& mesh, unsigned int instanceCount) {
+    size_t kept = (size_t)std::min(mesh.instanceCount, instanceCount) * sizeof(BuildingInstance);
+
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, (size_t)instanceCount * sizeof(BuildingInstance), NULL, GL_STATIC_DRAW);
+    if (kept) {
+        glBindBuffer(GL_COPY_READ_BUFFER, mesh.instanceVBO);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, kept);
+    }
+    glDeleteBuffers(1, &mesh.instanceVBO);
+    mesh.instanceVBO = buffer;
+    mesh.instanceCount = instanceCount;
+
+    glBindVertexArray(mesh.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.instanceVBO);
+    bindInstanceAttributes(0);
+    glBindVertexArray(0);
+}
+
+void drawInstancedMesh(const InstancedMesh& mesh) {
+    glBindVertexArray(mesh.VAO);
+    glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0, mesh.instanceCount);
+}
+
+void drawInstancedMeshRanges(const InstancedMesh& mesh, const std::vector<DrawRange>& ranges) {
+    if (ranges.empty())
+        return;
+
+    glBindVertexArray(mesh.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.instanceVBO);
+    for (size_t i = 0; i < ranges.size(); i++) {
+        bindInstanceAttributes(ranges[i].first);
+        glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0, ranges[i].count);
+    }
+
+    // Leave the VAO pointing at the full instance buffer
+    bindInstanceAttributes(0);
+}
+
+void destroyInstancedMesh(InstancedMesh& mesh) {
+    glDeleteVertexArrays(1, &mesh.VAO);
+    glDeleteBuffers(1, &mesh.cubeVBO);
+    glDeleteBuffers(1, &mesh.cubeEBO);
+    glDeleteBuffers(1, &mesh.instanceVBO);
+}
@@ -0,0 +1,70 @@
+#ifndef INSTANCING_H
+#define INSTANCING_H
+
+#include "city.h"
+#include "spatial_grid.h"
+#include "stream_buffer.h"
+
+#include <cstddef>
+#include <vector>
+
+// Per-building attributes streamed once per instance (36 bytes instead of
+// the 8 vertices + 36 indices createBuildingBuffers() emits per box)
+struct BuildingInstance {
+    float offset[3];
+    float scale[3]; // width, height, depth
+    float color[3];
+};
+
+// GPU objects for the instanced building path
+struct InstancedMesh {
+    unsigned int VAO;
+    unsigned int cubeVBO;
+    unsigned int cubeEBO;
+    unsigned int instanceVBO;
+    unsigned int indexCount;
+    unsigned int instanceCount;
+};
+
+// Unit cube centered on the origin, positions only, same winding as createBuildingBuffers()
+void createUnitCube(std::vector<float>& vertices, std::vector<unsigned int>& indices);
+
+// Draw indices per box once the bottom face is dropped. Every building is
+// centered on y = 0, so its bottom lies inside or under the ground slab, and
+// the slab's own bottom faces away from any camera above the city.
+static const unsigned int SURFACE_CUBE_INDICES = 30;
+
+// The unit cube's indices without the bottom face, triangles reordered for the
+// post-transform cache by optimizeVertexCache()
+void createSurfaceCubeIndices(std::vector<unsigned int>& indices);
+
+// Convert buildings to tightly packed instance records, split across pool when given
+void createInstanceData(const std::vector<Building>& buildings, std::vector<BuildingInstance>& instances,
+                        ThreadPool* pool);
+
+// Upload the shared cube and one instance record per building, staging the
+// instance records through stream when one is given. pool fills the mapped
+// instance buffer from every thread.
+InstancedMesh createInstancedMesh(const std::vector<Building>& buildings, StreamBuffer* stream, ThreadPool* pool);
+
+// Upload prebuilt instance records as they are, null instances only allocates
+InstancedMesh createInstancedMesh(const BuildingInstance* instances, size_t instanceCount, StreamBuffer* stream);
+
+// Rewrite instance records [first, first + count) in place through the ring
+void updateInstancedMesh(InstancedMesh& mesh, StreamBuffer& stream, unsigned int first,
+                         const Building* buildings, unsigned int count);
+
+// Reallocate the instance buffer for instanceCount records, keeping the existing
+// ones with a GPU-side copy. New records are undefined until updated.
+void resizeInstancedMesh(InstancedMesh& mesh, unsigned int instanceCount);
+
+// Draw every instance with a single glDrawElementsInstanced call
+void drawInstancedMesh(const InstancedMesh& mesh);
+
+// Draw only the given instance ranges, rebasing the instance attributes per range
+// (GL 3.3 has no baseInstance parameter)
+void drawInstancedMeshRanges(const InstancedMesh& mesh, const std::vector<DrawRange>& ranges);
+
+void destroyInstancedMesh(InstancedMesh& mesh);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef JOB_QUEUE_H
+#define JOB_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Bounded lock-free queue for any number of producer threads and a single
+// consumer (Vyukov's sequence-numbered ring). Every cell carries a sequence
+// number that tells producers and the consumer whose turn it is, so neither
+// side ever takes a lock or waits on the other. push() fails instead of
+// blocking when the ring is full; callers bound what they have in flight.
+template <typename T>
+class MpscQueue {
+public:
+    // capacity is rounded up to a power of two
+    explicit MpscQueue(size_t capacity) : head(0), tail(0) {
+        size_t size = 1;
+        while (size < capacity)
+            size *= 2;
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+    // Any thread. False when the ring is full.
+    bool push(const T& value) {
+        size_t position = head.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[position & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+            if (diff == 0) {
+                // The cell is free for this lap, claim the slot
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only. False when nothing is ready.
+    bool pop(T& value) {
+        Cell& cell = cells[tail & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != tail + 1)
+            return false;
+        value = cell.value;
+        // Hand the cell back to producers for the next lap
+        cell.sequence.store(tail + mask + 1, std::memory_order_release);
+        tail++;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    MpscQueue(const MpscQueue&);
+    MpscQueue& operator=(const MpscQueue&);
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    // Producers and the consumer each keep to their own cache line
+    std::atomic<size_t> head;
+    char padding[64];
+    size_t tail;
+};
+
+#endif
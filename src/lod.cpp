@@ -0,0 +1,228 @@
+#include "lod.h"
+
+#include <algorithm>
+
+LodSettings defaultLodSettings() {
+    LodSettings settings;
+    settings.enabled = true;
+    settings.blockDistance = 300.0f;
+    settings.districtDistance = 600.0f;
+    settings.blockDivisions = 4;
+    return settings;
+}
+
+// Box spanning the given bounds
+static Building boundsBuilding(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& color) {
+    Building b;
+    b.position = (boundsMin + boundsMax) * 0.5f;
+    b.width = boundsMax.x - boundsMin.x;
+    b.height = boundsMax.y - boundsMin.y;
+    b.depth = boundsMax.z - boundsMin.z;
+    b.color = color;
+    return b;
+}
+
+static void appendCellRange(std::vector<DrawRange>& ranges, size_t first, size_t end) {
+    DrawRange range;
+    range.first = first;
+    range.count = end - first;
+    ranges.push_back(range);
+}
+
+// One column per occupied sub-square of the cell, covering its members' footprints
+static void buildBlocks(const GridCell& cell, const std::vector<Building>& buildings, int divisions,
+                        std::vector<Building>& out) {
+    int columns = divisions * divisions;
+    std::vector<glm::vec3> columnMin(columns), columnMax(columns), columnColor(columns, glm::vec3(0.0f));
+    std::vector<float> columnArea(columns, 0.0f);
+
+    glm::vec3 extent = glm::max(cell.boundsMax - cell.boundsMin, glm::vec3(1e-6f));
+    for (unsigned int i = cell.first; i < cell.first + cell.count; i++) {
+        const Building& b = buildings[i];
+        int cx = std::min(divisions - 1, (int)((b.position.x - cell.boundsMin.x) / extent.x * divisions));
+        int cz = std::min(divisions - 1, (int)((b.position.z - cell.boundsMin.z) / extent.z * divisions));
+        int c = cz * divisions + cx;
+
+        glm::vec3 bMin, bMax;
+        buildingBounds(b, bMin, bMax);
+        float area = b.width * b.depth;
+        if (columnArea[c] == 0.0f) {
+            columnMin[c] = bMin;
+            columnMax[c] = bMax;
+        } else {
+            columnMin[c] = glm::min(columnMin[c], bMin);
+            columnMax[c] = glm::max(columnMax[c], bMax);
+        }
+        columnColor[c] += b.color * area;
+        columnArea[c] += area;
+    }
+
+    for (int c = 0; c < columns; c++) {
+        if (columnArea[c] > 0.0f)
+            out.push_back(boundsBuilding(columnMin[c], columnMax[c], columnColor[c] / columnArea[c]));
+    }
+}
+
+// A single box over the cell footprint whose height is the footprint-weighted mean
+static Building buildDistrict(const GridCell& cell, const std::vector<Building>& buildings) {
+    float area = 0.0f;
+    float top = 0.0f;
+    glm::vec3 color(0.0f);
+    for (unsigned int i = cell.first; i < cell.first + cell.count; i++) {
+        const Building& b = buildings[i];
+        float a = b.width * b.depth;
+        top += (b.position.y + b.height / 2.0f) * a;
+        color += b.color * a;
+        area += a;
+    }
+
+    glm::vec3 boundsMax = cell.boundsMax;
+    boundsMax.y = std::max(cell.boundsMin.y, top / area);
+    return boundsBuilding(cell.boundsMin, boundsMax, color / area);
+}
+
+// Append both proxy levels of one cell
+static void appendCellProxies(const GridCell& cell, const std::vector<Building>& buildings, int blockDivisions,
+                              LodProxies& proxies) {
+    size_t first = proxies.buildings[0].size();
+    if (cell.count)
+        buildBlocks(cell, buildings, blockDivisions, proxies.buildings[0]);
+    appendCellRange(proxies.ranges[0], first, proxies.buildings[0].size());
+
+    first = proxies.buildings[1].size();
+    if (cell.count)
+        proxies.buildings[1].push_back(buildDistrict(cell, buildings));
+    appendCellRange(proxies.ranges[1], first, proxies.buildings[1].size());
+}
+
+static void clearProxies(LodProxies& proxies, size_t cellCount) {
+    for (int level = 0; level < LOD_LEVELS - 1; level++) {
+        proxies.buildings[level].clear();
+        proxies.ranges[level].clear();
+        proxies.ranges[level].reserve(cellCount);
+    }
+}
+
+void buildLodProxies(const SpatialGrid& grid, const std::vector<Building>& buildings, int blockDivisions,
+                     LodProxies& proxies) {
+    clearProxies(proxies, grid.cells.size());
+    for (size_t c = 0; c < grid.cells.size(); c++)
+        appendCellProxies(grid.cells[c], buildings, blockDivisions, proxies);
+}
+
+void updateLodProxies(const SpatialGrid& grid, const std::vector<Building>& buildings, int blockDivisions,
+                      const std::vector<unsigned char>& dirtyCells, LodProxies& proxies) {
+    LodProxies updated;
+    clearProxies(updated, grid.cells.size());
+    for (size_t c = 0; c < grid.cells.size(); c++) {
+        if (dirtyCells[c]) {
+            appendCellProxies(grid.cells[c], buildings, blockDivisions, updated);
+            continue;
+        }
+        for (int level = 0; level < LOD_LEVELS - 1; level++) {
+            const DrawRange& range = proxies.ranges[level][c];
+            std::vector<Building>& out = updated.buildings[level];
+            size_t first = out.size();
+            out.insert(out.end(), proxies.buildings[level].begin() + range.first,
+                       proxies.buildings[level].begin() + range.first + range.count);
+            appendCellRange(updated.ranges[level], first, out.size());
+        }
+    }
+    for (int level = 0; level < LOD_LEVELS - 1; level++) {
+        proxies.buildings[level].swap(updated.buildings[level]);
+        proxies.ranges[level].swap(updated.ranges[level]);
+    }
+}
+
+LodGeometry createLodGeometry(const SpatialGrid& grid, const std::vector<Building>& buildings,
+                              const LodSettings& settings, bool instanced, bool packedVertices,
+                              StreamBuffer* stream) {
+    LodProxies proxies;
+    buildLodProxies(grid, buildings, settings.blockDivisions, proxies);
+    return createLodGeometry(proxies, instanced, packedVertices, stream);
+}
+
+LodGeometry createLodGeometry(LodProxies& proxies, bool instanced, bool packedVertices, StreamBuffer* stream) {
+    LodGeometry lod = LodGeometry();
+    lod.instanced = instanced;
+
+    for (int level = 0; level < LOD_LEVELS - 1; level++) {
+        lod.cellRanges[level].swap(proxies.ranges[level]);
+        if (proxies.buildings[level].empty())
+            continue;
+        if (instanced)
+            lod.instancedMeshes[level] = createInstancedMesh(proxies.buildings[level], stream, nullptr);
+        else
+            lod.buildingMeshes[level] = createBuildingMesh(proxies.buildings[level], packedVertices, stream, nullptr);
+    }
+    return lod;
+}
+
+static float boxDistance(const glm::vec3& point, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    return glm::length(point - glm::clamp(point, boundsMin, boundsMax));
+}
+
+int selectCellLod(const LodSettings& settings, const GridCell& cell, const glm::vec3& cameraPos) {
+    if (!settings.enabled)
+        return 0;
+    float distance = boxDistance(cameraPos, cell.boundsMin, cell.boundsMax);
+    if (distance >= settings.districtDistance)
+        return 2;
+    if (distance >= settings.blockDistance)
+        return 1;
+    return 0;
+}
+
+void selectLod(const SpatialGrid& grid, const LodGeometry& lod, const LodSettings& settings,
+               const Frustum& frustum, const glm::vec3& cameraPos, std::vector<DrawRange> ranges[LOD_LEVELS]) {
+    for (int level = 0; level < LOD_LEVELS; level++)
+        ranges[level].clear();
+
+    for (size_t c = 0; c < grid.cells.size(); c++) {
+        const GridCell& cell = grid.cells[c];
+        if (!cell.count || !boxInFrustum(frustum, cell.boundsMin, cell.boundsMax))
+            continue;
+
+        int level = selectCellLod(settings, cell, cameraPos);
+        if (level)
+            appendDrawRange(ranges[level], lod.cellRanges[level - 1][c].first, lod.cellRanges[level - 1][c].count);
+        else
+            appendDrawRange(ranges[0], cell.first, cell.count);
+    }
+    for (size_t c = 0; c < grid.oversized.size(); c++) {
+        const GridCell& cell = grid.oversized[c];
+        if (boxInFrustum(frustum, cell.boundsMin, cell.boundsMax))
+            appendDrawRange(ranges[0], cell.first, cell.count);
+    }
+}
+
+void drawLodProxies(const LodGeometry& lod, const std::vector<DrawRange> ranges[LOD_LEVELS]) {
+    for (int level = 1; level < LOD_LEVELS; level++) {
+        if (ranges[level].empty())
+            continue;
+        if (lod.instanced)
+            drawInstancedMeshRanges(lod.instancedMeshes[level - 1], ranges[level]);
+        else
+            drawBuildingMeshRanges(lod.buildingMeshes[level - 1], ranges[level]);
+    }
+}
+
+void queueLodProxies(RenderQueue& queue, unsigned int program, float distance, const LodGeometry& lod,
+                     const std::vector<DrawRange> ranges[LOD_LEVELS]) {
+    for (int level = 1; level < LOD_LEVELS; level++) {
+        if (lod.instanced)
+            queueInstancedMesh(queue, program, level, distance, lod.instancedMeshes[level - 1], ranges[level], 0);
+        else
+            queueBuildingMesh(queue, program, level, distance, lod.buildingMeshes[level - 1], ranges[level], 0);
+    }
+}
+
+void destroyLodGeometry(LodGeometry& lod) {
+    for (int level = 0; level < LOD_LEVELS - 1; level++) {
+        if (lod.instanced)
+            destroyInstancedMesh(lod.instancedMeshes[level]);
+        else
+            destroyBuildingMesh(lod.buildingMeshes[level]);
+        lod.cellRanges[level].clear();
+    }
+}
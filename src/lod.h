@@ -0,0 +1,79 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include "building_mesh.h"
+#include "city.h"
+#include "instancing.h"
+#include "render_queue.h"
+#include "spatial_grid.h"
+#include "stream_buffer.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Detail levels: full buildings, merged block columns, one box per grid cell
+static const int LOD_LEVELS = 3;
+
+// Camera distances at which grid cells switch to coarser proxies
+struct LodSettings {
+    bool enabled;
+    float blockDistance;    // beyond this a cell draws its block columns
+    float districtDistance; // beyond this a cell draws a single box
+    int blockDivisions;     // block columns per cell edge
+};
+
+LodSettings defaultLodSettings();
+
+// Coarse stand-ins for one spatial grid, stored in cell order.
+// ranges[level - 1][c] are the proxies of grid cell c at that level.
+struct LodProxies {
+    std::vector<Building> buildings[LOD_LEVELS - 1];
+    std::vector<DrawRange> ranges[LOD_LEVELS - 1];
+};
+
+// GPU side of the proxies, only the per-cell ranges stay on the CPU
+struct LodGeometry {
+    std::vector<DrawRange> cellRanges[LOD_LEVELS - 1];
+    BuildingMesh buildingMeshes[LOD_LEVELS - 1];
+    InstancedMesh instancedMeshes[LOD_LEVELS - 1];
+    bool instanced;
+};
+
+// Merge the buildings of every grid cell into block columns (tallest member, so the
+// skyline survives) and a district box (footprint-weighted mean height and color)
+void buildLodProxies(const SpatialGrid& grid, const std::vector<Building>& buildings, int blockDivisions,
+                     LodProxies& proxies);
+
+// Rebuild the proxies of the cells flagged in dirtyCells (one flag per grid
+// cell), copying every other cell's from proxies, which must match grid
+void updateLodProxies(const SpatialGrid& grid, const std::vector<Building>& buildings, int blockDivisions,
+                      const std::vector<unsigned char>& dirtyCells, LodProxies& proxies);
+
+// Build the proxies and upload them in the layout the scene draws with
+LodGeometry createLodGeometry(const SpatialGrid& grid, const std::vector<Building>& buildings,
+                              const LodSettings& settings, bool instanced, bool packedVertices,
+                              StreamBuffer* stream);
+
+// Upload proxies built elsewhere (a worker thread); their ranges are moved out
+LodGeometry createLodGeometry(LodProxies& proxies, bool instanced, bool packedVertices, StreamBuffer* stream);
+
+// Level a grid cell should draw at from its distance to the camera
+int selectCellLod(const LodSettings& settings, const GridCell& cell, const glm::vec3& cameraPos);
+
+// Frustum cull the grid and pick a level for every visible cell from its distance
+// to the camera. ranges[0] indexes the full buildings, ranges[1..] the proxies.
+// Oversized entries (the ground) always stay at full detail.
+void selectLod(const SpatialGrid& grid, const LodGeometry& lod, const LodSettings& settings,
+               const Frustum& frustum, const glm::vec3& cameraPos, std::vector<DrawRange> ranges[LOD_LEVELS]);
+
+// Draw the proxy levels of a selection, level 0 is drawn by the owner of the full mesh
+void drawLodProxies(const LodGeometry& lod, const std::vector<DrawRange> ranges[LOD_LEVELS]);
+
+// Queue the proxy levels of a selection instead, each at its own level
+void queueLodProxies(RenderQueue& queue, unsigned int program, float distance, const LodGeometry& lod,
+                     const std::vector<DrawRange> ranges[LOD_LEVELS]);
+
+void destroyLodGeometry(LodGeometry& lod);
+
+#endif
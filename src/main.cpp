@@ -4,163 +4,219 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "city_edit.h"
+#include "content_hash.h"
+#include "frame_benchmark.h"
+#include "frame_cache.h"
+#include "frame_pacing.h"
+#include "gl_extensions.h"
+#include "options.h"
+#include "profiler.h"
+#include "scene.h"
+#include "shader_cache.h"
+#include "thread_pool.h"
+#include "tile_render.h"
+
+#include <cmath>
 #include <iostream>
 #include <vector>
-#include <random>
-#include <chrono>
 
-// Shader source code
-const char* vertexShaderSource = R"(
-#version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aColor;
+// Camera movement in world units per second
+static const float CAMERA_SPEED = 60.0f;
 
-out vec3 FragColor;
+// Longest sleep of an idle window; input, resizes and exposes wake it sooner
+static const double IDLE_WAIT_SECONDS = 0.5;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Sleep while world chunks are still arriving, they wake nothing up themselves
+static const double STREAMING_WAIT_SECONDS = 1.0 / 30.0;
 
-void main()
-{
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    FragColor = aColor;
-}
-)";
-
-const char* fragmentShaderSource = R"(
-#version 330 core
-in vec3 FragColor;
-out vec4 FragOutput;
-
-void main()
-{
-    FragOutput = vec4(FragColor, 1.0);
-}
-)";
-
-// Building structure
-struct Building {
-    glm::vec3 position;
-    float width;
-    float depth;
-    float height;
-    glm::vec3 color;
-};
+// Set when the window system asks for a repaint of the current contents
+static bool windowDamaged = false;
 
 // Function declarations
-GLFWwindow* initializeWindow();
-unsigned int compileShaders();
-void generateCity(std::vector<Building>& buildings, int numBuildings);
-void createBuildingBuffers(const std::vector<Building>& buildings, 
-                          std::vector<float>& vertices, 
-                          std::vector<unsigned int>& indices);
-void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFront);
+GLFWwindow* initializeWindow(int width, int height, bool visible, bool preferGL43);
+void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFront, float deltaTime);
+std::vector<SceneView> layoutViews(const std::vector<glm::vec3>& cameraPositions,
+                                   const std::vector<glm::vec3>& cameraFronts, int width, int height);
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
+void windowRefreshCallback(GLFWwindow* window);
 
-int main() {
-    // Initialize window
-    GLFWwindow* window = initializeWindow();
-    if (!window) return -1;
-
-    // Compile shaders
-    unsigned int shaderProgram = compileShaders();
-    if (!shaderProgram) return -1;
-
-    // Generate city data
-    std::vector<Building> buildings;
-    generateCity(buildings, 100); // Generate 100 buildings
+int main(int argc, char** argv) {
+    AppOptions options;
+    if (!parseOptions(argc, argv, options)) return -1;
+    setShaderCacheDirectory(options.shaderCache);
 
-    // Create vertex and index data
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
-    createBuildingBuffers(buildings, vertices, indices);
-
-    // Set up vertex buffer objects and vertex array objects
-    unsigned int VBO, VAO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    // Initialize window, hidden when it only provides a context for benchmarking or a still
+    bool offscreen = options.benchmark || !options.renderOutput.empty();
+    GLFWwindow* window = initializeWindow(options.width, options.height, !offscreen, options.gpuCull);
+    if (!window) return -1;
 
-    glBindVertexArray(VAO);
+    if (options.profile)
+        initProfiler(true, options.traceOutput);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    if (options.benchmark) {
+        int result = runFrameBenchmark(options, window);
+        printProfilerSummary(std::cerr);
+        shutdownProfiler();
+        glfwTerminate();
+        return result;
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    if (!options.renderOutput.empty()) {
+        int result = runTileRender(options, window);
+        printProfilerSummary(std::cerr);
+        shutdownProfiler();
+        glfwTerminate();
+        return result;
+    }
 
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Color attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // Worker threads for generation
+    ThreadPool pool(options.threads);
+
+    // Generate and upload the city
+    CityScene scene;
+    SceneTimings timings;
+    if (!createScene(options, pool, scene, timings)) return -1;
+    if (options.profile) {
+        std::cout << "Scene ready: " << timings.geometryBytes / (1024 * 1024) << " MB geometry, peak RSS "
+                  << timings.peakResidentBytes / (1024 * 1024) << " MB" << std::endl;
+        for (unsigned int i = 0; i < VERTEX_CACHE_REPORT_COUNT; i++) {
+            VertexCacheStats handWritten, optimized;
+            measureChunkIndices(VERTEX_CACHE_REPORT_SIZES[i], handWritten, optimized);
+            std::cout << "Chunk indices, " << VERTEX_CACHE_REPORT_SIZES[i] << "-entry FIFO: ACMR "
+                      << handWritten.acmr << " -> " << optimized.acmr << ", ATVR " << handWritten.atvr
+                      << " -> " << optimized.atvr << std::endl;
+        }
+    }
+    if (options.hash) {
+        uint64_t buildingsHash, geometryHash;
+        hashScene(scene, buildingsHash, geometryHash);
+        std::cout << "Seed " << options.seed << ": buildings " << hashString(buildingsHash)
+                  << ", geometry " << hashString(geometryHash) << std::endl;
+    }
 
-    // Get uniform locations
-    unsigned int modelLoc = glGetUniformLocation(shaderProgram, "model");
-    unsigned int viewLoc = glGetUniformLocation(shaderProgram, "view");
-    unsigned int projectionLoc = glGetUniformLocation(shaderProgram, "projection");
+    // Camera setup, one per view. The first looks at the city from the south,
+    // the others from evenly spaced bearings around it; Tab moves the keyboard
+    // to the next view.
+    std::vector<glm::vec3> cameraPositions(options.views);
+    std::vector<glm::vec3> cameraFronts(options.views);
+    for (int i = 0; i < options.views; i++) {
+        float bearing = 6.2831853f * i / options.views;
+        glm::vec3 offset = glm::vec3(std::sin(bearing), 0.0f, std::cos(bearing));
+        cameraPositions[i] = glm::vec3(0.0f, 50.0f, 0.0f) + 150.0f * offset;
+        cameraFronts[i] = -offset;
+    }
+    int activeView = 0;
+    bool switchHeld = false;
 
-    // Enable depth testing
-    glEnable(GL_DEPTH_TEST);
+    // Timing
+    FramePacer pacer;
+    initFramePacer(pacer, options.vsync, options.targetFps);
+    float lastTitleUpdate = 0.0f;
 
-    // Camera setup
-    glm::vec3 cameraPos = glm::vec3(0.0f, 50.0f, 150.0f);
-    glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
-    glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
+    // Idle mode draws into an offscreen cache and redraws only when the frame
+    // state changed; otherwise the window sleeps in glfwWaitEventsTimeout and
+    // re-presents the cache if it was damaged. The profiler needs a steady
+    // stream of frames, so it keeps rendering.
+    bool idle = options.idle && !options.profile;
+    FrameCache frameCache = createFrameCache();
 
-    // Timing
-    float deltaTime = 0.0f;
-    float lastFrame = 0.0f;
+    // District regeneration on R, once per key press
+    bool regenerateHeld = false;
+    unsigned int regenerations = 0;
 
     // Render loop
     while (!glfwWindowShouldClose(window)) {
         // Per-frame time logic
+        float deltaTime = beginPacedFrame(pacer);
         float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // Process input
-        processInput(window, cameraPos, cameraFront);
-
-        // Clear the screen
-        glClearColor(0.1f, 0.1f, 0.2f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Activate shader
-        glUseProgram(shaderProgram);
-
-        // Create transformations
-        glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
-        glm::mat4 model = glm::mat4(1.0f);
-
-        // Set matrices in shader
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+        beginProfilerFrame();
+
+        // Process input for the view that has the keyboard
+        bool switchDown = glfwGetKey(window, GLFW_KEY_TAB) == GLFW_PRESS;
+        if (switchDown && !switchHeld)
+            activeView = (activeView + 1) % options.views;
+        switchHeld = switchDown;
+        glm::vec3& cameraPos = cameraPositions[activeView];
+        glm::vec3& cameraFront = cameraFronts[activeView];
+        processInput(window, cameraPos, cameraFront, deltaTime);
+
+        // Rebuild the 64 unit district where the view ray meets the ground, patching only its cells
+        bool regenerateDown = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
+        if (regenerateDown && !regenerateHeld && !options.world) {
+            glm::vec3 focus = cameraPos;
+            if (cameraFront.y < -1e-3f)
+                focus -= cameraFront * (cameraPos.y / cameraFront.y);
+            regenerateRegion(scene, focus - glm::vec3(32.0f), focus + glm::vec3(32.0f), -1,
+                             options.seed + ++regenerations);
+        }
+        regenerateHeld = regenerateDown;
+
+        // Stream the city around every camera
+        updateScene(scene, cameraPositions);
+
+        // Nothing on screen would change: present the cached frame only if the window lost it.
+        // Only the active view's camera can have moved since the last drawn frame, so it
+        // stands in for all of them.
+        FrameState frameState;
+        frameState.cameraPos = cameraPos;
+        frameState.cameraFront = cameraFront;
+        glfwGetFramebufferSize(window, &frameState.width, &frameState.height);
+        frameState.sceneRevision = sceneRevision(scene);
+        if (idle && frameUnchanged(frameCache, frameState)) {
+            if (windowDamaged) {
+                presentCachedFrame(frameCache);
+                glfwSwapBuffers(window);
+                windowDamaged = false;
+            }
+            endProfilerFrame();
+            glfwWaitEventsTimeout(sceneStreaming(scene) ? STREAMING_WAIT_SECONDS : IDLE_WAIT_SECONDS);
+            continue;
+        }
 
-        // Draw buildings
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        // Draw, into the cache when idling is on so the frame can be presented again later
+        bool cached = idle && beginCachedFrame(frameCache, frameState);
+        if (options.views == 1) {
+            float aspect = frameState.height > 0 ? (float)frameState.width / (float)frameState.height : 1.0f;
+            renderScene(scene, cameraPos, cameraFront, aspect);
+        } else {
+            renderScene(scene, layoutViews(cameraPositions, cameraFronts, frameState.width, frameState.height));
+            glViewport(0, 0, frameState.width, frameState.height);
+        }
+        if (cached)
+            presentCachedFrame(frameCache);
+        windowDamaged = false;
+
+        // Timing bars on top, averages in the title twice a second
+        if (options.profileOverlay) {
+            drawProfilerOverlay(frameState.width, frameState.height);
+            if (currentFrame - lastTitleUpdate > 0.5f) {
+                glfwSetWindowTitle(window, ("City Landscape | " + profilerTitle()).c_str());
+                lastTitleUpdate = currentFrame;
+            }
+        }
 
         // Swap buffers and poll events
-        glfwSwapBuffers(window);
+        {
+            PROFILE_SCOPE("swap");
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
+        endProfilerFrame();
+        waitForNextFrame(pacer);
     }
 
     // Clean up
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-    glDeleteProgram(shaderProgram);
+    destroyFrameCache(frameCache);
+    printProfilerSummary(std::cout);
+    shutdownProfiler();
+    destroyScene(scene);
 
     glfwTerminate();
     return 0;
 }
 
-GLFWwindow* initializeWindow() {
+GLFWwindow* initializeWindow(int width, int height, bool visible, bool preferGL43) {
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -171,9 +227,19 @@ GLFWwindow* initializeWindow() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // Create window
-    GLFWwindow* window = glfwCreateWindow(800, 600, "City Landscape", NULL, NULL);
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+
+    // Create window, asking for 4.3 first when GPU culling wants it and keeping 3.3 as the fallback
+    GLFWwindow* window = NULL;
+    if (preferGL43) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(width, height, "City Landscape", NULL, NULL);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    }
+    if (!window)
+        window = glfwCreateWindow(width, height, "City Landscape", NULL, NULL);
     if (!window) {
         std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -182,6 +248,7 @@ GLFWwindow* initializeWindow() {
 
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    glfwSetWindowRefreshCallback(window, windowRefreshCallback);
 
     // Initialize GLAD
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
@@ -189,187 +256,18 @@ GLFWwindow* initializeWindow() {
         return nullptr;
     }
 
-    return window;
-}
-
-unsigned int compileShaders() {
-    // Vertex shader
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    // Check for vertex shader compile errors
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-        return 0;
-    }
+    // Optional entry points newer than GL 3.3
+    loadGLExtensions();
 
-    // Fragment shader
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    // Check for fragment shader compile errors
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-        return 0;
-    }
-
-    // Link shaders
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    // Check for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-        return 0;
-    }
-
-    // Delete shaders as they're linked into program and no longer necessary
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return shaderProgram;
-}
-
-void generateCity(std::vector<Building>& buildings, int numBuildings) {
-    // Random number generation
-    std::mt19937 rng(std::chrono::steady_clock::now().time_since_epoch().count());
-    std::uniform_real_distribution<float> posDistX(-100.0f, 100.0f);
-    std::uniform_real_distribution<float> posDistZ(-100.0f, 100.0f);
-    std::uniform_real_distribution<float> sizeDistWidth(5.0f, 15.0f);
-    std::uniform_real_distribution<float> sizeDistDepth(5.0f, 15.0f);
-    std::uniform_real_distribution<float> heightDist(10.0f, 60.0f);
-    std::uniform_real_distribution<float> colorDist(0.2f, 0.8f);
-
-    // Generate buildings with random properties
-    for (int i = 0; i < numBuildings; i++) {
-        Building building;
-        building.position = glm::vec3(posDistX(rng), 0.0f, posDistZ(rng));
-        building.width = sizeDistWidth(rng);
-        building.depth = sizeDistDepth(rng);
-        building.height = heightDist(rng);
-
-        // Night city colors - blues, purples, etc.
-        if (i % 5 == 0) {
-            // Make some buildings emit more light (bright colors)
-            building.color = glm::vec3(colorDist(rng) * 0.5f + 0.5f, 
-                                      colorDist(rng) * 0.5f + 0.5f, 
-                                      colorDist(rng) * 0.5f + 0.5f);
-        } else {
-            // Regular buildings, more muted colors
-            building.color = glm::vec3(colorDist(rng) * 0.3f, 
-                                      colorDist(rng) * 0.3f, 
-                                      colorDist(rng) * 0.5f + 0.3f);
-        }
-
-        buildings.push_back(building);
-    }
-
-    // Add ground plane
-    Building ground;
-    ground.position = glm::vec3(0.0f, -0.5f, 0.0f);
-    ground.width = 250.0f;
-    ground.depth = 250.0f;
-    ground.height = 1.0f;
-    ground.color = glm::vec3(0.1f, 0.1f, 0.1f); // Dark gray
-    buildings.push_back(ground);
-}
-
-void createBuildingBuffers(const std::vector<Building>& buildings, 
-                          std::vector<float>& vertices, 
-                          std::vector<unsigned int>& indices) {
-    for (size_t i = 0; i < buildings.size(); i++) {
-        const Building& b = buildings[i];
-        
-        // Calculate half dimensions for convenience
-        float hw = b.width / 2.0f;
-        float hh = b.height / 2.0f;
-        float hd = b.depth / 2.0f;
-        
-        // Base index for this building
-        unsigned int baseIndex = vertices.size() / 6;
-
-        // Each vertex has: position (3 floats) + color (3 floats)
-        // Define 8 vertices of the building (a cube)
-        
-        // Bottom vertices
-        // Front-left
-        vertices.push_back(b.position.x - hw); vertices.push_back(b.position.y - hh); vertices.push_back(b.position.z + hd);
-        vertices.push_back(b.color.r); vertices.push_back(b.color.g); vertices.push_back(b.color.b);
-        
-        // Front-right
-        vertices.push_back(b.position.x + hw); vertices.push_back(b.position.y - hh); vertices.push_back(b.position.z + hd);
-        vertices.push_back(b.color.r); vertices.push_back(b.color.g); vertices.push_back(b.color.b);
-        
-        // Back-right
-        vertices.push_back(b.position.x + hw); vertices.push_back(b.position.y - hh); vertices.push_back(b.position.z - hd);
-        vertices.push_back(b.color.r); vertices.push_back(b.color.g); vertices.push_back(b.color.b);
-        
-        // Back-left
-        vertices.push_back(b.position.x - hw); vertices.push_back(b.position.y - hh); vertices.push_back(b.position.z - hd);
-        vertices.push_back(b.color.r); vertices.push_back(b.color.g); vertices.push_back(b.color.b);
-        
-        // Top vertices
-        // Front-left
-        vertices.push_back(b.position.x - hw); vertices.push_back(b.position.y + hh); vertices.push_back(b.position.z + hd);
-        vertices.push_back(b.color.r + 0.1f); vertices.push_back(b.color.g + 0.1f); vertices.push_back(b.color.b + 0.1f);
-        
-        // Front-right
-        vertices.push_back(b.position.x + hw); vertices.push_back(b.position.y + hh); vertices.push_back(b.position.z + hd);
-        vertices.push_back(b.color.r + 0.1f); vertices.push_back(b.color.g + 0.1f); vertices.push_back(b.color.b + 0.1f);
-        
-        // Back-right
-        vertices.push_back(b.position.x + hw); vertices.push_back(b.position.y + hh); vertices.push_back(b.position.z - hd);
-        vertices.push_back(b.color.r + 0.1f); vertices.push_back(b.color.g + 0.1f); vertices.push_back(b.color.b + 0.1f);
-        
-        // Back-left
-        vertices.push_back(b.position.x - hw); vertices.push_back(b.position.y + hh); vertices.push_back(b.position.z - hd);
-        vertices.push_back(b.color.r + 0.1f); vertices.push_back(b.color.g + 0.1f); vertices.push_back(b.color.b + 0.1f);
-        
-        // Define the 12 triangles (6 faces, 2 triangles per face)
-        // Bottom face
-        indices.push_back(baseIndex + 0); indices.push_back(baseIndex + 1); indices.push_back(baseIndex + 2);
-        indices.push_back(baseIndex + 2); indices.push_back(baseIndex + 3); indices.push_back(baseIndex + 0);
-        
-        // Top face
-        indices.push_back(baseIndex + 4); indices.push_back(baseIndex + 7); indices.push_back(baseIndex + 6);
-        indices.push_back(baseIndex + 6); indices.push_back(baseIndex + 5); indices.push_back(baseIndex + 4);
-        
-        // Front face
-        indices.push_back(baseIndex + 0); indices.push_back(baseIndex + 4); indices.push_back(baseIndex + 5);
-        indices.push_back(baseIndex + 5); indices.push_back(baseIndex + 1); indices.push_back(baseIndex + 0);
-        
-        // Right face
-        indices.push_back(baseIndex + 1); indices.push_back(baseIndex + 5); indices.push_back(baseIndex + 6);
-        indices.push_back(baseIndex + 6); indices.push_back(baseIndex + 2); indices.push_back(baseIndex + 1);
-        
-        // Back face
-        indices.push_back(baseIndex + 2); indices.push_back(baseIndex + 6); indices.push_back(baseIndex + 7);
-        indices.push_back(baseIndex + 7); indices.push_back(baseIndex + 3); indices.push_back(baseIndex + 2);
-        
-        // Left face
-        indices.push_back(baseIndex + 3); indices.push_back(baseIndex + 7); indices.push_back(baseIndex + 4);
-        indices.push_back(baseIndex + 4); indices.push_back(baseIndex + 0); indices.push_back(baseIndex + 3);
-    }
+    return window;
 }
 
-void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFront) {
+void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFront, float deltaTime) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    // Camera movement
-    float cameraSpeed = 1.0f;
+    // Camera movement, the same distance per second at any frame rate
+    float cameraSpeed = CAMERA_SPEED * deltaTime;
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
         cameraPos += cameraSpeed * cameraFront;
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
@@ -384,6 +282,32 @@ void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFro
         cameraPos -= glm::vec3(0.0f, cameraSpeed, 0.0f);
 }
 
+std::vector<SceneView> layoutViews(const std::vector<glm::vec3>& cameraPositions,
+                                   const std::vector<glm::vec3>& cameraFronts, int width, int height) {
+    // Near-square grid filled row by row from the top left, edges rounded so the tiles meet exactly
+    int count = (int)cameraPositions.size();
+    int columns = (int)std::ceil(std::sqrt((float)count));
+    int rows = (count + columns - 1) / columns;
+    std::vector<SceneView> views(count);
+    for (int i = 0; i < count; i++) {
+        int column = i % columns;
+        int row = i / columns;
+        SceneView& view = views[i];
+        view.cameraPos = cameraPositions[i];
+        view.cameraFront = cameraFronts[i];
+        view.x = column * width / columns;
+        view.width = (column + 1) * width / columns - view.x;
+        view.y = (rows - 1 - row) * height / rows;
+        view.height = (rows - row) * height / rows - view.y;
+    }
+    return views;
+}
+
 void framebufferSizeCallback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
-}
\ No newline at end of file
+}
+
+void windowRefreshCallback(GLFWwindow* window) {
+    (void)window;
+    windowDamaged = true;
+}
@@ -0,0 +1,104 @@
+#include "occlusion.h"
+#include "instancing.h"
+#include "shaders.h"
+
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+
+OcclusionCuller createOcclusionCuller(const SpatialGrid& grid, float occluderDistance) {
+    OcclusionCuller culler = OcclusionCuller();
+    culler.occluderDistance = occluderDistance;
+
+    culler.program = compileShaderProgram(occlusionBoxVertexSource, fragmentShaderSource);
+    if (!culler.program) {
+        std::cerr << "ERROR::OCCLUSION::PROGRAM_FAILED" << std::endl;
+        return culler;
+    }
+    culler.boundsMinLoc = glGetUniformLocation(culler.program, "boundsMin");
+    culler.boundsMaxLoc = glGetUniformLocation(culler.program, "boundsMax");
+
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    createUnitCube(vertices, indices);
+
+    glGenVertexArrays(1, &culler.VAO);
+    glGenBuffers(1, &culler.VBO);
+    glGenBuffers(1, &culler.EBO);
+    glBindVertexArray(culler.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, culler.VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, culler.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    culler.queries.resize(grid.cells.size());
+    if (!culler.queries.empty())
+        glGenQueries(culler.queries.size(), culler.queries.data());
+    return culler;
+}
+
+void partitionOccluders(const OcclusionCuller& culler, const SpatialGrid& grid, const Frustum& frustum,
+                        const glm::vec3& cameraPos, std::vector<unsigned int>& occluders,
+                        std::vector<unsigned int>& candidates) {
+    occluders.clear();
+    candidates.clear();
+    for (size_t c = 0; c < grid.cells.size(); c++) {
+        const GridCell& cell = grid.cells[c];
+        if (!cell.count || !boxInFrustum(frustum, cell.boundsMin, cell.boundsMax))
+            continue;
+
+        // A box the camera is in (or clipped by the near plane) would wrongly test hidden
+        float distance = glm::length(cameraPos - glm::clamp(cameraPos, cell.boundsMin, cell.boundsMax));
+        if (distance <= culler.occluderDistance)
+            occluders.push_back(c);
+        else
+            candidates.push_back(c);
+    }
+}
+
+void issueOcclusionQueries(const OcclusionCuller& culler, const SpatialGrid& grid,
+                           const std::vector<unsigned int>& candidates) {
+    if (candidates.empty())
+        return;
+
+    glUseProgram(culler.program);
+    glBindVertexArray(culler.VAO);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        const GridCell& cell = grid.cells[candidates[i]];
+        glUniform3fv(culler.boundsMinLoc, 1, glm::value_ptr(cell.boundsMin));
+        glUniform3fv(culler.boundsMaxLoc, 1, glm::value_ptr(cell.boundsMax));
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, culler.queries[candidates[i]]);
+        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+    }
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+}
+
+void beginOcclusionDraw(const OcclusionCuller& culler, unsigned int cell) {
+    // NO_WAIT: draw anyway rather than stall if the result isn't in yet
+    glBeginConditionalRender(culler.queries[cell], GL_QUERY_NO_WAIT);
+}
+
+void endOcclusionDraw() {
+    glEndConditionalRender();
+}
+
+void destroyOcclusionCuller(OcclusionCuller& culler) {
+    if (!culler.queries.empty())
+        glDeleteQueries(culler.queries.size(), culler.queries.data());
+    culler.queries.clear();
+    glDeleteVertexArrays(1, &culler.VAO);
+    glDeleteBuffers(1, &culler.VBO);
+    glDeleteBuffers(1, &culler.EBO);
+    if (culler.program)
+        glDeleteProgram(culler.program);
+}
@@ -0,0 +1,46 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include "spatial_grid.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Occlusion culling per grid cell for a fixed city. Cells near the camera are
+// drawn first as occluders, then the bounds of every other visible cell are
+// rasterized into a GL_ANY_SAMPLES_PASSED query with color and depth writes
+// off, and the cell's geometry is drawn under glBeginConditionalRender so the
+// GPU drops hidden cells without a CPU readback.
+struct OcclusionCuller {
+    unsigned int program;
+    int boundsMinLoc;
+    int boundsMaxLoc;
+    unsigned int VAO;
+    unsigned int VBO;
+    unsigned int EBO;
+    std::vector<unsigned int> queries; // one per grid cell
+    float occluderDistance;
+};
+
+// Returns a culler with program 0 on failure
+OcclusionCuller createOcclusionCuller(const SpatialGrid& grid, float occluderDistance);
+
+// Split the frustum-visible cells into occluders (within occluderDistance of the
+// camera, which includes any cell the camera stands in) and cells to test
+void partitionOccluders(const OcclusionCuller& culler, const SpatialGrid& grid, const Frustum& frustum,
+                        const glm::vec3& cameraPos, std::vector<unsigned int>& occluders,
+                        std::vector<unsigned int>& candidates);
+
+// Rasterize the bounds of every candidate into its query with this frame's
+// FrameUniforms camera. Leaves the culler's program bound, the caller rebinds its own.
+void issueOcclusionQueries(const OcclusionCuller& culler, const SpatialGrid& grid,
+                           const std::vector<unsigned int>& candidates);
+
+// Wrap the draws of one tested cell, skipped on the GPU if its box had no samples
+void beginOcclusionDraw(const OcclusionCuller& culler, unsigned int cell);
+void endOcclusionDraw();
+
+void destroyOcclusionCuller(OcclusionCuller& culler);
+
+#endif
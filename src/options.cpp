@@ -0,0 +1,254 @@
+#include "options.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --width <px>, --height <px>  Window or benchmark target size (default 800x600)\n"
+              << "  --buildings <n>   Number of buildings to generate (default 100)\n"
+              << "  --layout <l>      scatter (random boxes in +-100) or roads (non-overlapping lots on a road grid)\n"
+              << "  --instanced       Draw one shared cube per building with glDrawElementsInstanced\n"
+              << "  --packed-vertices  Quantize baked vertices to 12 bytes (16-bit positions, RGBA8 color)\n"
+              << "  --no-cull         Draw every building instead of frustum culling grid cells\n"
+              << "  --cell-size <u>   Spatial grid cell size in world units (default 32)\n"
+              << "  --far <u>         Far clip plane distance (default 1000)\n"
+              << "  --no-lod          Draw every visible building at full detail\n"
+              << "  --lod-block <u>   Distance beyond which grid cells draw merged block columns (default 300)\n"
+              << "  --lod-district <u>  Distance beyond which grid cells draw a single box (default 600)\n"
+              << "  --occlusion       Skip grid cells hidden behind nearby cells with occlusion queries\n"
+              << "  --occluder-distance <u>  Cells closer than this are drawn first as occluders (default 100)\n"
+              << "  --gpu-cull        Frustum cull in a compute shader and draw with glMultiDrawElementsIndirect (GL 4.3)\n"
+              << "  --stream-mb <n>   Size of each of the 3 dynamic upload ring sections in MB (default 4)\n"
+              << "  --no-buffer-storage  Use glMapBufferRange with orphaning instead of a persistent mapping\n"
+              << "  --seed <n>        Generation seed (default: from the clock, 1 with --benchmark or --render)\n"
+              << "  --hash            Print content hashes of the generated buildings and geometry\n"
+              << "  --shader-cache <dir>  Directory for cached shader program binaries (default city_shader_cache)\n"
+              << "  --no-shader-cache  Always compile shaders from source\n"
+              << "  --threads <n>     Worker threads, 0 for one per hardware thread (default 0)\n"
+              << "  --save-snapshot <file>  Write the generated city and its GPU buffers to file\n"
+              << "  --load-snapshot <file>  Map a saved city instead of generating one\n"
+              << "  --benchmark       Render offscreen in a hidden window and print timings as JSON\n"
+              << "  --frames <n>      Benchmark frames to measure (default 300)\n"
+              << "  --warmup <n>      Benchmark frames rendered before measuring (default 10)\n"
+              << "  --camera-path <p> static, orbit, flyover or a file of \"px py pz fx fy fz\" keys (default orbit)\n"
+              << "  --json <file>     Write the benchmark report to file instead of stdout\n"
+              << "  --render <file>   Render one still from the start of the camera path to a PPM file and exit\n"
+              << "  --render-width <px>, --render-height <px>  Still size (default 16384x9216)\n"
+              << "  --tile <px>       Edge length of the tiles a still is drawn in (default 1024)\n"
+              << "  --world           Stream an unbounded tiled city around the camera\n"
+              << "  --chunk-size <u>  World chunk edge length (default 200)\n"
+              << "  --chunk-buildings <n>  Buildings per world chunk (default 100)\n"
+              << "  --view-radius <n> Chunks kept loaded around the camera chunk (default 5)\n"
+              << "  --upload-budget <KB>  Bytes of finished world chunks uploaded per frame (default 1024)\n"
+              << "  --sync-chunks     Build world chunks on the render thread instead of the workers\n"
+              << "  --no-vsync        Present without waiting for vertical blank\n"
+              << "  --fps <n>         Cap the interactive frame rate by sleeping, 0 for no cap (default 0)\n"
+              << "  --no-idle         Redraw every frame even when nothing on screen changed\n"
+              << "  --views <n>       Split the window into n viewports with their own cameras, Tab switches (default 1)\n"
+              << "  --profile         Time clear, draw, update and swap on the CPU and GPU, print a summary on exit\n"
+              << "  --profile-overlay Also draw per-phase timing bars and show averages in the window title\n"
+              << "  --trace <file>    Also write every profiled scope to a Chrome trace JSON file\n";
+}
+
+bool parseOptions(int argc, char** argv, AppOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--width") == 0 && i + 1 < argc) {
+            options.width = std::atoi(argv[++i]);
+            if (options.width <= 0) {
+                std::cerr << "ERROR::OPTIONS::INVALID_SIZE" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--height") == 0 && i + 1 < argc) {
+            options.height = std::atoi(argv[++i]);
+            if (options.height <= 0) {
+                std::cerr << "ERROR::OPTIONS::INVALID_SIZE" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--buildings") == 0 && i + 1 < argc) {
+            options.numBuildings = std::atoi(argv[++i]);
+            if (options.numBuildings < 0) {
+                std::cerr << "ERROR::OPTIONS::INVALID_BUILDING_COUNT" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--layout") == 0 && i + 1 < argc) {
+            const char* layout = argv[++i];
+            if (std::strcmp(layout, "roads") == 0) {
+                options.roads = true;
+            } else if (std::strcmp(layout, "scatter") == 0) {
+                options.roads = false;
+            } else {
+                std::cerr << "ERROR::OPTIONS::UNKNOWN_LAYOUT " << layout << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--instanced") == 0) {
+            options.instanced = true;
+        } else if (std::strcmp(arg, "--packed-vertices") == 0) {
+            options.packedVertices = true;
+        } else if (std::strcmp(arg, "--no-cull") == 0) {
+            options.cull = false;
+        } else if (std::strcmp(arg, "--cell-size") == 0 && i + 1 < argc) {
+            options.cellSize = (float)std::atof(argv[++i]);
+            if (options.cellSize <= 0.0f) {
+                std::cerr << "ERROR::OPTIONS::INVALID_CELL_SIZE" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--far") == 0 && i + 1 < argc) {
+            options.farPlane = (float)std::atof(argv[++i]);
+            if (options.farPlane <= 1.0f) {
+                std::cerr << "ERROR::OPTIONS::INVALID_FAR_PLANE" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--no-lod") == 0) {
+            options.lod = false;
+        } else if (std::strcmp(arg, "--lod-block") == 0 && i + 1 < argc) {
+            options.lodBlockDistance = (float)std::atof(argv[++i]);
+            if (options.lodBlockDistance < 0.0f) {
+                std::cerr << "ERROR::OPTIONS::INVALID_LOD_DISTANCE" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--lod-district") == 0 && i + 1 < argc) {
+            options.lodDistrictDistance = (float)std::atof(argv[++i]);
+            if (options.lodDistrictDistance < 0.0f) {
+                std::cerr << "ERROR::OPTIONS::INVALID_LOD_DISTANCE" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--occlusion") == 0) {
+            options.occlusion = true;
+        } else if (std::strcmp(arg, "--occluder-distance") == 0 && i + 1 < argc) {
+            options.occluderDistance = (float)std::atof(argv[++i]);
+            if (options.occluderDistance < 0.0f) {
+                std::cerr << "ERROR::OPTIONS::INVALID_OCCLUDER_DISTANCE" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--gpu-cull") == 0) {
+            options.gpuCull = true;
+        } else if (std::strcmp(arg, "--stream-mb") == 0 && i + 1 < argc) {
+            int megabytes = std::atoi(argv[++i]);
+            if (megabytes <= 0 || megabytes > 1024) {
+                std::cerr << "ERROR::OPTIONS::INVALID_STREAM_SIZE" << std::endl;
+                return false;
+            }
+            options.streamSectionBytes = (unsigned int)megabytes * 1024 * 1024;
+        } else if (std::strcmp(arg, "--no-buffer-storage") == 0) {
+            options.bufferStorage = false;
+        } else if (std::strcmp(arg, "--hash") == 0) {
+            options.hash = true;
+        } else if (std::strcmp(arg, "--seed") == 0 && i + 1 < argc) {
+            options.seed = (unsigned int)std::strtoul(argv[++i], NULL, 10);
+            options.fixedSeed = true;
+        } else if (std::strcmp(arg, "--shader-cache") == 0 && i + 1 < argc) {
+            options.shaderCache = argv[++i];
+        } else if (std::strcmp(arg, "--no-shader-cache") == 0) {
+            options.shaderCache.clear();
+        } else if (std::strcmp(arg, "--threads") == 0 && i + 1 < argc) {
+            options.threads = (unsigned int)std::strtoul(argv[++i], NULL, 10);
+        } else if (std::strcmp(arg, "--save-snapshot") == 0 && i + 1 < argc) {
+            options.saveSnapshot = argv[++i];
+        } else if (std::strcmp(arg, "--load-snapshot") == 0 && i + 1 < argc) {
+            options.loadSnapshot = argv[++i];
+        } else if (std::strcmp(arg, "--benchmark") == 0) {
+            options.benchmark = true;
+        } else if (std::strcmp(arg, "--frames") == 0 && i + 1 < argc) {
+            options.frames = std::atoi(argv[++i]);
+            if (options.frames <= 0) {
+                std::cerr << "ERROR::OPTIONS::INVALID_FRAME_COUNT" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--warmup") == 0 && i + 1 < argc) {
+            options.warmupFrames = std::atoi(argv[++i]);
+            if (options.warmupFrames < 0) {
+                std::cerr << "ERROR::OPTIONS::INVALID_FRAME_COUNT" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--camera-path") == 0 && i + 1 < argc) {
+            options.cameraPath = argv[++i];
+        } else if (std::strcmp(arg, "--json") == 0 && i + 1 < argc) {
+            options.jsonOutput = argv[++i];
+        } else if (std::strcmp(arg, "--render") == 0 && i + 1 < argc) {
+            options.renderOutput = argv[++i];
+        } else if (std::strcmp(arg, "--render-width") == 0 && i + 1 < argc) {
+            options.renderWidth = std::atoi(argv[++i]);
+            if (options.renderWidth <= 0) {
+                std::cerr << "ERROR::OPTIONS::INVALID_SIZE" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--render-height") == 0 && i + 1 < argc) {
+            options.renderHeight = std::atoi(argv[++i]);
+            if (options.renderHeight <= 0) {
+                std::cerr << "ERROR::OPTIONS::INVALID_SIZE" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--tile") == 0 && i + 1 < argc) {
+            options.renderTile = std::atoi(argv[++i]);
+            if (options.renderTile <= 0) {
+                std::cerr << "ERROR::OPTIONS::INVALID_TILE_SIZE" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--world") == 0) {
+            options.world = true;
+        } else if (std::strcmp(arg, "--chunk-size") == 0 && i + 1 < argc) {
+            options.chunkSize = (float)std::atof(argv[++i]);
+            if (options.chunkSize <= 0.0f) {
+                std::cerr << "ERROR::OPTIONS::INVALID_CHUNK_SIZE" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--chunk-buildings") == 0 && i + 1 < argc) {
+            options.chunkBuildings = std::atoi(argv[++i]);
+            if (options.chunkBuildings < 0) {
+                std::cerr << "ERROR::OPTIONS::INVALID_BUILDING_COUNT" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--view-radius") == 0 && i + 1 < argc) {
+            options.viewRadius = std::atoi(argv[++i]);
+            if (options.viewRadius < 0) {
+                std::cerr << "ERROR::OPTIONS::INVALID_VIEW_RADIUS" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--upload-budget") == 0 && i + 1 < argc) {
+            int kilobytes = std::atoi(argv[++i]);
+            if (kilobytes <= 0) {
+                std::cerr << "ERROR::OPTIONS::INVALID_UPLOAD_BUDGET" << std::endl;
+                return false;
+            }
+            options.uploadBudgetBytes = (size_t)kilobytes * 1024;
+        } else if (std::strcmp(arg, "--sync-chunks") == 0) {
+            options.syncChunks = true;
+        } else if (std::strcmp(arg, "--no-vsync") == 0) {
+            options.vsync = false;
+        } else if (std::strcmp(arg, "--fps") == 0 && i + 1 < argc) {
+            options.targetFps = (float)std::atof(argv[++i]);
+            if (options.targetFps < 0.0f) {
+                std::cerr << "ERROR::OPTIONS::INVALID_FPS" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--no-idle") == 0) {
+            options.idle = false;
+        } else if (std::strcmp(arg, "--views") == 0 && i + 1 < argc) {
+            options.views = std::atoi(argv[++i]);
+            if (options.views < 1) {
+                std::cerr << "ERROR::OPTIONS::INVALID_VIEW_COUNT" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(arg, "--profile") == 0) {
+            options.profile = true;
+        } else if (std::strcmp(arg, "--profile-overlay") == 0) {
+            options.profile = true;
+            options.profileOverlay = true;
+        } else if (std::strcmp(arg, "--trace") == 0 && i + 1 < argc) {
+            options.profile = true;
+            options.traceOutput = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+
+    // Benchmarks and stills pin the scene so runs stay comparable
+    if (!options.fixedSeed)
+        options.seed = options.benchmark || !options.renderOutput.empty() ? 1 : (unsigned int)std::chrono::steady_clock::now().time_since_epoch().count();
+    return true;
+}
@@ -0,0 +1,90 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <cstddef>
+#include <string>
+
+// Command line configurable settings
+struct AppOptions {
+    int width = 800;
+    int height = 600;
+    int numBuildings = 100;
+    bool instanced = false;
+    bool cull = true;
+    bool packedVertices = false;
+    float cellSize = 32.0f;
+    bool roads = false; // road grid layout instead of uniform scatter
+    float farPlane = 1000.0f;
+
+    // Distance based level of detail over the grid cells
+    bool lod = true;
+    float lodBlockDistance = 300.0f;
+    float lodDistrictDistance = 600.0f;
+
+    // Per grid cell occlusion queries behind the nearest cells
+    bool occlusion = false;
+    float occluderDistance = 100.0f;
+
+    // Compute shader frustum culling with indirect draws, needs GL 4.3
+    bool gpuCull = false;
+
+    // Dynamic geometry staging ring
+    unsigned int streamSectionBytes = 4 * 1024 * 1024;
+    bool bufferStorage = true;
+
+    // Worker threads, 0 uses every hardware thread
+    unsigned int threads = 0;
+
+    // Generation seed, picked from the clock unless --seed was given
+    unsigned int seed = 0;
+    bool fixedSeed = false;
+
+    // Print content hashes of the generated city
+    bool hash = false;
+
+    // Directory for linked shader program binaries, empty disables the cache
+    std::string shaderCache = "city_shader_cache";
+
+    // Binary city snapshots
+    std::string saveSnapshot;
+    std::string loadSnapshot;
+
+    // Headless frame benchmark
+    bool benchmark = false;
+    int frames = 300;
+    int warmupFrames = 10;
+    std::string cameraPath = "orbit";
+    std::string jsonOutput;
+
+    // Offline tiled still, rendered instead of opening a window when renderOutput is set
+    std::string renderOutput;
+    int renderWidth = 16384;
+    int renderHeight = 9216;
+    int renderTile = 1024;
+
+    // Tiled streaming world
+    bool world = false;
+    float chunkSize = 200.0f;
+    int chunkBuildings = 100;
+    int viewRadius = 5;
+    size_t uploadBudgetBytes = 1024 * 1024;
+    bool syncChunks = false;
+
+    // Interactive frame pacing, targetFps 0 leaves the rate to vsync
+    bool vsync = true;
+    float targetFps = 0.0f;
+    bool idle = true;
+
+    // Viewports tiling the window, each with its own camera over the same buffers
+    int views = 1;
+
+    // Frame profiler
+    bool profile = false;
+    bool profileOverlay = false;
+    std::string traceOutput;
+};
+
+// Parse argv into options, prints usage and returns false on bad input
+bool parseOptions(int argc, char** argv, AppOptions& options);
+
+#endif
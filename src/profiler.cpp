@@ -0,0 +1,394 @@
+#include "profiler.h"
+#include "shaders.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// Frames kept in each rolling window
+static const int PROFILER_WINDOW = 240;
+
+// Stop recording trace events past this many, about 40 MB of JSON
+static const size_t PROFILER_MAX_TRACE_EVENTS = 500000;
+
+// Query sets in flight, frame N reuses the set of frame N - 2
+static const int PROFILER_QUERY_SETS = 2;
+
+struct ProfileZone {
+    const char* name;
+    float cpuMs[PROFILER_WINDOW];
+    float gpuMs[PROFILER_WINDOW];
+    int cpuCount;
+    int gpuCount;
+    double cpuFrameTotal; // accumulated while the current frame is open
+};
+
+struct ScopeRecord {
+    int zone;
+    int64_t cpuBeginUs;
+    int64_t cpuEndUs;
+    int gpuBegin; // query indices in the frame's set, -1 without GPU timers
+    int gpuEnd;
+};
+
+struct QuerySet {
+    std::vector<unsigned int> queries;
+    size_t used;
+    std::vector<ScopeRecord> records;
+};
+
+struct TraceEvent {
+    const char* name;
+    int64_t beginUs;
+    int64_t durationUs;
+    int thread; // 1 = CPU, 2 = GPU
+};
+
+struct ProfilerState {
+    bool enabled;
+    bool gpu;
+    bool frameOpen;
+    std::chrono::steady_clock::time_point epoch;
+    int64_t gpuToCpuUs; // add to GPU timestamp / 1000 to land on the CPU timeline
+    QuerySet sets[PROFILER_QUERY_SETS];
+    int current;
+    std::vector<ProfileZone> zones;
+    std::vector<TraceEvent> trace;
+    std::string tracePath;
+    size_t droppedGpuFrames;
+    unsigned int overlayProgram;
+    unsigned int overlayVAO;
+    unsigned int overlayVBO;
+};
+
+static ProfilerState state = ProfilerState();
+
+static const char* overlayVertexSource = R"(
+#version 330 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec3 aColor;
+out vec3 FragColor;
+void main()
+{
+    gl_Position = vec4(aPos, 0.0, 1.0);
+    FragColor = aColor;
+}
+)";
+
+static int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - state.epoch).count();
+}
+
+static int findZone(const char* name) {
+    for (size_t i = 0; i < state.zones.size(); i++) {
+        if (state.zones[i].name == name || std::strcmp(state.zones[i].name, name) == 0)
+            return i;
+    }
+    ProfileZone zone = ProfileZone();
+    zone.name = name;
+    state.zones.push_back(zone);
+    return state.zones.size() - 1;
+}
+
+static int acquireQuery(QuerySet& set) {
+    if (set.used == set.queries.size()) {
+        set.queries.resize(set.queries.size() + 16);
+        glGenQueries(16, &set.queries[set.used]);
+    }
+    return set.used++;
+}
+
+static void pushSample(float* window, int& count, float value) {
+    window[count % PROFILER_WINDOW] = value;
+    count++;
+}
+
+static void addTrace(const char* name, int64_t beginUs, int64_t endUs, int thread) {
+    if (state.tracePath.empty() || state.trace.size() >= PROFILER_MAX_TRACE_EVENTS)
+        return;
+    TraceEvent event;
+    event.name = name;
+    event.beginUs = beginUs;
+    event.durationUs = endUs - beginUs;
+    event.thread = thread;
+    state.trace.push_back(event);
+}
+
+// Read the GPU half of a set recorded two frames ago, dropping it if still in flight
+static void collectGpuResults(QuerySet& set) {
+    if (set.records.empty())
+        return;
+
+    if (state.gpu && set.used) {
+        GLint available = 0;
+        glGetQueryObjectiv(set.queries[set.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            state.droppedGpuFrames++;
+        } else {
+            std::vector<double> totals(state.zones.size(), 0.0);
+            for (size_t i = 0; i < set.records.size(); i++) {
+                const ScopeRecord& r = set.records[i];
+                if (r.gpuBegin < 0 || r.gpuEnd < 0)
+                    continue;
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(set.queries[r.gpuBegin], GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(set.queries[r.gpuEnd], GL_QUERY_RESULT, &end);
+                totals[r.zone] += (end - begin) / 1.0e6;
+                addTrace(state.zones[r.zone].name, (int64_t)(begin / 1000) + state.gpuToCpuUs,
+                         (int64_t)(end / 1000) + state.gpuToCpuUs, 2);
+            }
+            for (size_t z = 0; z < totals.size(); z++)
+                pushSample(state.zones[z].gpuMs, state.zones[z].gpuCount, (float)totals[z]);
+        }
+    }
+
+    set.records.clear();
+    set.used = 0;
+}
+
+void initProfiler(bool gpuTimers, const std::string& tracePath) {
+    state.enabled = true;
+    state.gpu = gpuTimers;
+    state.epoch = std::chrono::steady_clock::now();
+    state.tracePath = tracePath;
+    state.current = 0;
+
+    if (state.gpu) {
+        // Align GPU timestamps with the CPU clock for the trace
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        state.gpuToCpuUs = nowUs() - gpuNow / 1000;
+    }
+}
+
+bool profilerEnabled() {
+    return state.enabled;
+}
+
+void beginProfilerFrame() {
+    if (!state.enabled)
+        return;
+
+    state.current = (state.current + 1) % PROFILER_QUERY_SETS;
+    collectGpuResults(state.sets[state.current]);
+    for (size_t z = 0; z < state.zones.size(); z++)
+        state.zones[z].cpuFrameTotal = 0.0;
+    state.frameOpen = true;
+}
+
+void endProfilerFrame() {
+    if (!state.enabled || !state.frameOpen)
+        return;
+
+    for (size_t z = 0; z < state.zones.size(); z++)
+        pushSample(state.zones[z].cpuMs, state.zones[z].cpuCount, (float)state.zones[z].cpuFrameTotal);
+    state.frameOpen = false;
+}
+
+ProfileScope::ProfileScope(const char* name) : record(-1) {
+    if (!state.enabled || !state.frameOpen)
+        return;
+
+    QuerySet& set = state.sets[state.current];
+    ScopeRecord r;
+    r.zone = findZone(name);
+    r.gpuBegin = -1;
+    r.gpuEnd = -1;
+    if (state.gpu) {
+        r.gpuBegin = acquireQuery(set);
+        glQueryCounter(set.queries[r.gpuBegin], GL_TIMESTAMP);
+    }
+    r.cpuBeginUs = nowUs();
+    r.cpuEndUs = r.cpuBeginUs;
+    record = set.records.size();
+    set.records.push_back(r);
+}
+
+ProfileScope::~ProfileScope() {
+    if (record < 0 || !state.frameOpen)
+        return;
+
+    QuerySet& set = state.sets[state.current];
+    if (state.gpu) {
+        int query = acquireQuery(set);
+        glQueryCounter(set.queries[query], GL_TIMESTAMP);
+        set.records[record].gpuEnd = query;
+    }
+
+    ScopeRecord& r = set.records[record];
+    r.cpuEndUs = nowUs();
+    ProfileZone& zone = state.zones[r.zone];
+    zone.cpuFrameTotal += (r.cpuEndUs - r.cpuBeginUs) / 1000.0;
+    addTrace(zone.name, r.cpuBeginUs, r.cpuEndUs, 1);
+}
+
+struct WindowStats {
+    float mean;
+    float p50;
+    float p95;
+    float max;
+};
+
+static WindowStats windowStats(const float* window, int count) {
+    WindowStats stats = WindowStats();
+    int n = std::min(count, PROFILER_WINDOW);
+    if (n == 0)
+        return stats;
+
+    std::vector<float> sorted(window, window + n);
+    std::sort(sorted.begin(), sorted.end());
+    float sum = 0.0f;
+    for (int i = 0; i < n; i++)
+        sum += sorted[i];
+    stats.mean = sum / n;
+    stats.p50 = sorted[n / 2];
+    stats.p95 = sorted[std::min(n - 1, (int)(n * 0.95f))];
+    stats.max = sorted[n - 1];
+    return stats;
+}
+
+void printProfilerSummary(std::ostream& out) {
+    if (!state.enabled)
+        return;
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-12s %8s %8s %8s %8s | %8s %8s %8s %8s\n",
+                  "zone (ms)", "cpu avg", "p50", "p95", "max", "gpu avg", "p50", "p95", "max");
+    out << line;
+    for (size_t z = 0; z < state.zones.size(); z++) {
+        const ProfileZone& zone = state.zones[z];
+        WindowStats cpu = windowStats(zone.cpuMs, zone.cpuCount);
+        WindowStats gpu = windowStats(zone.gpuMs, zone.gpuCount);
+        std::snprintf(line, sizeof(line), "%-12s %8.3f %8.3f %8.3f %8.3f | %8.3f %8.3f %8.3f %8.3f\n",
+                      zone.name, cpu.mean, cpu.p50, cpu.p95, cpu.max, gpu.mean, gpu.p50, gpu.p95, gpu.max);
+        out << line;
+    }
+    if (state.droppedGpuFrames)
+        out << state.droppedGpuFrames << " GPU frames dropped (results not ready after two frames)\n";
+}
+
+std::string profilerTitle() {
+    std::ostringstream title;
+    title.setf(std::ios::fixed);
+    title.precision(2);
+    for (size_t z = 0; z < state.zones.size(); z++) {
+        const ProfileZone& zone = state.zones[z];
+        if (z)
+            title << " | ";
+        title << zone.name << " " << windowStats(zone.cpuMs, zone.cpuCount).mean;
+        if (state.gpu)
+            title << "/" << windowStats(zone.gpuMs, zone.gpuCount).mean;
+    }
+    return title.str();
+}
+
+static void appendQuad(std::vector<float>& vertices, float x0, float y0, float x1, float y1, const float* color) {
+    const float corners[6][2] = { { x0, y0 }, { x1, y0 }, { x1, y1 }, { x1, y1 }, { x0, y1 }, { x0, y0 } };
+    for (int i = 0; i < 6; i++) {
+        vertices.push_back(corners[i][0]);
+        vertices.push_back(corners[i][1]);
+        vertices.push_back(color[0]);
+        vertices.push_back(color[1]);
+        vertices.push_back(color[2]);
+    }
+}
+
+void drawProfilerOverlay(int width, int height) {
+    if (!state.enabled || state.zones.empty())
+        return;
+
+    if (!state.overlayProgram) {
+        state.overlayProgram = compileShaderProgram(overlayVertexSource, fragmentShaderSource);
+        if (!state.overlayProgram)
+            return;
+        glGenVertexArrays(1, &state.overlayVAO);
+        glGenBuffers(1, &state.overlayVBO);
+        glBindVertexArray(state.overlayVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, state.overlayVBO);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+    }
+
+    static const float palette[6][3] = {
+        { 0.9f, 0.3f, 0.3f }, { 0.3f, 0.9f, 0.3f }, { 0.3f, 0.5f, 1.0f },
+        { 0.9f, 0.8f, 0.2f }, { 0.8f, 0.3f, 0.9f }, { 0.2f, 0.9f, 0.9f }
+    };
+    static const float frameMarker[3] = { 1.0f, 1.0f, 1.0f };
+
+    // Bars along the top edge, 12 px tall, NDC x spans 33.3 ms
+    float barHeight = 24.0f / height;
+    float pixel = 2.0f / width;
+    float msToNdc = 2.0f / 33.3f;
+    std::vector<float> vertices;
+    for (int row = 0; row < 2; row++) {
+        if (row == 1 && !state.gpu)
+            break;
+        float y1 = 1.0f - row * (barHeight + 4.0f / height);
+        float y0 = y1 - barHeight;
+        float x = -1.0f;
+        for (size_t z = 0; z < state.zones.size(); z++) {
+            const ProfileZone& zone = state.zones[z];
+            float ms = row == 0 ? windowStats(zone.cpuMs, zone.cpuCount).mean : windowStats(zone.gpuMs, zone.gpuCount).mean;
+            float x1 = std::min(1.0f, x + ms * msToNdc);
+            appendQuad(vertices, x, y0, x1, y1, palette[z % 6]);
+            x = x1;
+        }
+        // 16.7 ms budget tick
+        appendQuad(vertices, -1.0f + 16.7f * msToNdc, y0, -1.0f + 16.7f * msToNdc + pixel, y1, frameMarker);
+    }
+
+    glDisable(GL_DEPTH_TEST);
+    glUseProgram(state.overlayProgram);
+    glBindVertexArray(state.overlayVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, state.overlayVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STREAM_DRAW);
+    glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 5);
+    glEnable(GL_DEPTH_TEST);
+}
+
+static void writeTrace() {
+    std::ofstream file(state.tracePath.c_str());
+    if (!file) {
+        std::cerr << "ERROR::PROFILER::TRACE_OPEN_FAILED " << state.tracePath << std::endl;
+        return;
+    }
+
+    file << "{\"traceEvents\":[\n"
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n"
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+    for (size_t i = 0; i < state.trace.size(); i++) {
+        const TraceEvent& e = state.trace[i];
+        file << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+             << ",\"ts\":" << e.beginUs << ",\"dur\":" << e.durationUs << "}";
+    }
+    file << "\n]}\n";
+}
+
+void shutdownProfiler() {
+    if (!state.enabled)
+        return;
+
+    if (!state.tracePath.empty())
+        writeTrace();
+
+    for (int s = 0; s < PROFILER_QUERY_SETS; s++) {
+        if (!state.sets[s].queries.empty())
+            glDeleteQueries(state.sets[s].queries.size(), state.sets[s].queries.data());
+    }
+    if (state.overlayProgram) {
+        glDeleteProgram(state.overlayProgram);
+        glDeleteVertexArrays(1, &state.overlayVAO);
+        glDeleteBuffers(1, &state.overlayVBO);
+    }
+    state = ProfilerState();
+}
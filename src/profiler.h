@@ -0,0 +1,50 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <ostream>
+#include <string>
+
+// Lightweight frame profiler. Named scopes record CPU time with steady_clock
+// and GPU time with a pair of GL_TIMESTAMP queries. Queries are double
+// buffered per frame and read back two frames later, so they never stall.
+// Per-zone totals go into rolling windows, and every scope can optionally be
+// recorded for a Chrome trace (chrome://tracing, Perfetto).
+
+// gpuTimers needs a current GL context, tracePath empty disables tracing
+void initProfiler(bool gpuTimers, const std::string& tracePath);
+
+bool profilerEnabled();
+
+// Call at the start and end of every frame
+void beginProfilerFrame();
+void endProfilerFrame();
+
+// RAII scope, does nothing while the profiler is disabled.
+// name must outlive the profiler (string literals).
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name);
+    ~ProfileScope();
+
+private:
+    int record;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+// One line per zone with mean/p50/p95/max of the rolling CPU and GPU windows
+void printProfilerSummary(std::ostream& out);
+
+// Compact single line summary, e.g. for a window title
+std::string profilerTitle();
+
+// Stacked bar per zone (CPU above, GPU below) drawn over the current framebuffer,
+// one screen width is 33.3 ms
+void drawProfilerOverlay(int width, int height);
+
+// Write the trace file if one was requested and release GL objects
+void shutdownProfiler();
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// SplitMix64 finalizer, a cheap high quality 64-bit mix
+inline uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Derive an independent stream key from a seed and a stream index
+inline uint64_t streamKey(uint64_t seed, uint64_t stream) {
+    return mix64(seed * 0x9E3779B97F4A7C15ull + mix64(stream + 0x632BE59BD9B4E019ull));
+}
+
+// Counter-based generator: value n of a stream is mix64(key + n * golden ratio),
+// so streams are independent, seekable and identical on every platform
+struct CounterRng {
+    uint64_t key;
+    uint64_t counter;
+
+    explicit CounterRng(uint64_t streamKey) : key(streamKey), counter(0) {}
+
+    uint64_t next() {
+        return mix64(key + (++counter) * 0x9E3779B97F4A7C15ull);
+    }
+
+    // Uniform float in [lo, hi) from the top 24 bits, no std distribution involved
+    float uniform(float lo, float hi) {
+        float unit = (float)(next() >> 40) * (1.0f / 16777216.0f);
+        return lo + (hi - lo) * unit;
+    }
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "render_queue.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+void clearRenderQueue(RenderQueue& queue) {
+    queue.batches.clear();
+    queue.ranges.clear();
+}
+
+static void queueBatch(RenderQueue& queue, RenderBatch& batch, const std::vector<DrawRange>& ranges,
+                       unsigned int baseSlot) {
+    if (ranges.empty())
+        return;
+    batch.firstRange = queue.ranges.size();
+    batch.rangeCount = ranges.size();
+    for (size_t i = 0; i < ranges.size(); i++) {
+        DrawRange range = { baseSlot + ranges[i].first, ranges[i].count };
+        queue.ranges.push_back(range);
+    }
+    queue.batches.push_back(batch);
+}
+
+void queueBuildingMesh(RenderQueue& queue, unsigned int program, int level, float distance, const BuildingMesh& mesh,
+                       const std::vector<DrawRange>& ranges, unsigned int baseSlot) {
+    RenderBatch batch = { program, level, distance, &mesh, nullptr, 0, 0 };
+    queueBatch(queue, batch, ranges, baseSlot);
+}
+
+void queueInstancedMesh(RenderQueue& queue, unsigned int program, int level, float distance,
+                        const InstancedMesh& mesh, const std::vector<DrawRange>& ranges, unsigned int baseSlot) {
+    RenderBatch batch = { program, level, distance, nullptr, &mesh, 0, 0 };
+    queueBatch(queue, batch, ranges, baseSlot);
+}
+
+// Batches that can go out as one draw: same state, same buffers
+static bool sameDraw(const RenderBatch& a, const RenderBatch& b) {
+    return a.program == b.program && a.level == b.level && a.buildingMesh == b.buildingMesh
+        && a.instancedMesh == b.instancedMesh;
+}
+
+void submitRenderQueue(RenderQueue& queue) {
+    // Sort indices rather than the batches; ties stay in queue order
+    const std::vector<RenderBatch>& batches = queue.batches;
+    queue.order.resize(batches.size());
+    for (size_t i = 0; i < batches.size(); i++)
+        queue.order[i] = i;
+    std::stable_sort(queue.order.begin(), queue.order.end(), [&batches](size_t a, size_t b) {
+        const RenderBatch& x = batches[a];
+        const RenderBatch& y = batches[b];
+        if (x.program != y.program)
+            return x.program < y.program;
+        if (x.level != y.level)
+            return x.level < y.level;
+        return x.distance < y.distance;
+    });
+
+    queue.submits = 0;
+    queue.drawCalls = 0;
+    unsigned int boundProgram = 0;
+    for (size_t i = 0; i < queue.order.size();) {
+        const RenderBatch& batch = batches[queue.order[i]];
+
+        // Concatenate the following batches of the same draw, still near to far
+        queue.scratch.clear();
+        for (; i < queue.order.size() && sameDraw(batches[queue.order[i]], batch); i++) {
+            const RenderBatch& part = batches[queue.order[i]];
+            for (size_t r = part.firstRange; r < part.firstRange + part.rangeCount; r++)
+                appendDrawRange(queue.scratch, queue.ranges[r].first, queue.ranges[r].count);
+        }
+
+        if (batch.program != boundProgram) {
+            glUseProgram(batch.program);
+            boundProgram = batch.program;
+        }
+        if (batch.buildingMesh) {
+            drawBuildingMeshRanges(*batch.buildingMesh, queue.scratch);
+            queue.drawCalls++;
+        } else {
+            drawInstancedMeshRanges(*batch.instancedMesh, queue.scratch);
+            queue.drawCalls += queue.scratch.size();
+        }
+        queue.submits++;
+    }
+}
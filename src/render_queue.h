@@ -0,0 +1,51 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "building_mesh.h"
+#include "instancing.h"
+#include "spatial_grid.h"
+
+#include <vector>
+
+// Draws recorded for one mesh: a baked or an instanced mesh (the other pointer
+// is null) and its ranges, stored contiguously in RenderQueue::ranges in the
+// mesh's own building slots
+struct RenderBatch {
+    unsigned int program;
+    int level;      // LOD level, full detail first
+    float distance; // camera distance, near first inside a level
+    const BuildingMesh* buildingMesh;
+    const InstancedMesh* instancedMesh;
+    size_t firstRange;
+    size_t rangeCount;
+};
+
+// Deferred submission for scenes built from many small meshes (streamed
+// chunks and their LOD proxies). Batches are sorted by program, then LOD
+// level, then near to far, so state is bound once per run and full-detail
+// geometry fills the depth buffer front to back before the proxies behind it.
+// Consecutive batches of the same program, level and mesh (chunks sharing a
+// ChunkArena) are merged, their ranges concatenated in sorted order into a
+// single glMultiDrawElementsBaseVertex.
+struct RenderQueue {
+    std::vector<RenderBatch> batches;
+    std::vector<DrawRange> ranges;
+    std::vector<size_t> order;      // submit scratch
+    std::vector<DrawRange> scratch; // ranges of the merged batches being drawn
+    unsigned int submits;   // merged submissions by the last submitRenderQueue()
+    unsigned int drawCalls; // GL draw calls they took, one per range for instanced meshes
+};
+
+void clearRenderQueue(RenderQueue& queue);
+
+// Record ranges of a mesh, which must stay alive until the queue is submitted.
+// baseSlot is added to every range, 0 unless the mesh is shared by many owners.
+void queueBuildingMesh(RenderQueue& queue, unsigned int program, int level, float distance, const BuildingMesh& mesh,
+                       const std::vector<DrawRange>& ranges, unsigned int baseSlot);
+void queueInstancedMesh(RenderQueue& queue, unsigned int program, int level, float distance,
+                        const InstancedMesh& mesh, const std::vector<DrawRange>& ranges, unsigned int baseSlot);
+
+// Sort, merge and draw everything queued, leaves the last program bound
+void submitRenderQueue(RenderQueue& queue);
+
+#endif
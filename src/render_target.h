@@ -0,0 +1,21 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+// Offscreen framebuffer with an RGBA8 color and a 24-bit depth attachment
+struct RenderTarget {
+    unsigned int framebuffer;
+    unsigned int color;
+    unsigned int depth;
+    int width;
+    int height;
+};
+
+// Returns a target with framebuffer 0 if the driver rejects the attachments
+RenderTarget createRenderTarget(int width, int height);
+
+// Bind for drawing and set the viewport to cover it
+void bindRenderTarget(const RenderTarget& target);
+
+void destroyRenderTarget(RenderTarget& target);
+
+#endif
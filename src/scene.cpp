@@ -0,0 +1,369 @@
+#include "scene.h"
+#include "city_layout.h"
+#include "content_hash.h"
+#include "geometry_builder.h"
+#include "gl_extensions.h"
+#include "profiler.h"
+#include "shaders.h"
+#include "snapshot.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Upload baked blobs for whichever path the scene draws with
+static void uploadCity(CityScene& scene, const std::vector<float>& vertices, const std::vector<BuildingInstance>& instances) {
+    if (scene.instanced)
+        scene.instancedMesh = createInstancedMesh(instances.data(), instances.size(), nullptr);
+    else
+        scene.buildingMesh = createBuildingMesh(vertices.data(), vertices.size(), scene.packedVertices, nullptr);
+}
+
+// Per-frame visibility structures over the uploaded city, once the grid and meshes exist
+static void createCullingData(CityScene& scene, const AppOptions& options) {
+    if (scene.gpuCull) {
+        scene.gpuCuller = options.instanced ? createGpuCuller(scene.instancedMesh) : createGpuCuller(scene.grid);
+        scene.gpuCull = scene.gpuCuller.program != 0;
+        if (scene.gpuCull)
+            return;
+    }
+    if (scene.lodSettings.enabled)
+        scene.lod = createLodGeometry(scene.grid, scene.buildings, scene.lodSettings, options.instanced,
+                                      scene.packedVertices, nullptr);
+    if (scene.occlusion)
+        scene.occlusionCuller = createOcclusionCuller(scene.grid, options.occluderDistance);
+    scene.occlusion = scene.occlusion && scene.occlusionCuller.program;
+}
+
+bool createScene(const AppOptions& options, ThreadPool& pool, CityScene& scene, SceneTimings& timings) {
+    timings = SceneTimings();
+    scene.instanced = options.instanced;
+    scene.cull = options.cull;
+    scene.world = options.world;
+    scene.farPlane = options.farPlane;
+    scene.buildingMesh = BuildingMesh();
+    scene.instancedMesh = InstancedMesh();
+    scene.lod = LodGeometry();
+    scene.occlusion = options.occlusion && options.cull && !options.world;
+    scene.occlusionCuller = OcclusionCuller();
+    scene.gpuCuller = GpuCuller();
+    scene.editState = CityEditState();
+    scene.revision = 0;
+
+    // GPU-driven culling needs a GL 4.3 context, otherwise the CPU paths below stay in charge
+    scene.gpuCull = options.gpuCull && options.cull && !options.world;
+    if (scene.gpuCull && !glExtensions.computeCulling) {
+        std::cerr << "GPU culling needs OpenGL 4.3, falling back to CPU culling" << std::endl;
+        scene.gpuCull = false;
+    }
+
+    // Coarser proxies need the grid to select from
+    scene.lodSettings = defaultLodSettings();
+    scene.lodSettings.enabled = options.lod && options.cull;
+    scene.lodSettings.blockDistance = options.lodBlockDistance;
+    scene.lodSettings.districtDistance = std::max(options.lodBlockDistance, options.lodDistrictDistance);
+
+    // Compile shaders
+    scene.packedVertices = options.packedVertices && !options.instanced;
+    if (options.instanced)
+        scene.shaderProgram = compileShaderProgram(instancedVertexShaderSource, fragmentShaderSource);
+    else if (scene.packedVertices)
+        scene.shaderProgram = compileShaderProgram(packedVertexShaderSource, fragmentShaderSource);
+    else
+        scene.shaderProgram = compileShaders();
+    if (!scene.shaderProgram) return false;
+
+    // Camera matrices and frustum planes, shared by every program through one uniform block
+    scene.frameUniforms = createFrameUniforms();
+
+    // Enable depth testing
+    glEnable(GL_DEPTH_TEST);
+
+    // Staging ring for geometry written after startup (streamed chunks, edits)
+    scene.stream = createStreamBuffer(options.streamSectionBytes, options.bufferStorage);
+
+    // Tiled world streamed around the camera
+    WorldSettings worldSettings = defaultWorldSettings();
+    worldSettings.chunkSize = options.chunkSize;
+    worldSettings.buildingsPerChunk = options.chunkBuildings;
+    worldSettings.viewRadius = options.viewRadius;
+    worldSettings.maxResidentChunks = (2 * options.viewRadius + 3) * (2 * options.viewRadius + 3) * options.views;
+    worldSettings.cellSize = options.cellSize;
+    worldSettings.seed = options.seed;
+    worldSettings.instanced = options.instanced;
+    worldSettings.packedVertices = scene.packedVertices;
+    worldSettings.lod = scene.lodSettings;
+    worldSettings.uploadBudgetBytes = options.uploadBudgetBytes;
+    scene.streamingWorld = createWorld(worldSettings, &scene.stream,
+                                       options.world && !options.syncChunks ? &pool : nullptr);
+
+    // Chunks are generated on demand by updateScene()
+    if (options.world)
+        return true;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (!options.loadSnapshot.empty()) {
+        CitySnapshot snapshot;
+        if (!openSnapshot(options.loadSnapshot.c_str(), snapshot)) return false;
+        scene.buildings.assign(snapshot.buildings, snapshot.buildings + snapshot.buildingCount);
+        scene.grid = snapshotGrid(snapshot);
+        timings.generationMs = millisecondsSince(start);
+
+        // Blobs go from the mapping straight into glBufferData
+        start = std::chrono::steady_clock::now();
+        if (options.instanced)
+            scene.instancedMesh = createInstancedMesh(snapshot.instances, snapshot.instanceCount, nullptr);
+        else
+            scene.buildingMesh = createBuildingMesh(snapshot.vertices, snapshot.vertexFloats, scene.packedVertices, nullptr);
+        createCullingData(scene, options);
+        glFinish();
+        timings.uploadMs = millisecondsSince(start);
+        GeometrySizes sizes = buildingGeometrySizes(snapshot.buildingCount, scene.packedVertices);
+        timings.geometryBytes = options.instanced ? sizes.instanceBytes : sizes.vertexBytes;
+        timings.peakResidentBytes = peakResidentBytes();
+        closeSnapshot(snapshot);
+        return true;
+    }
+
+    // Generate city data. The road layout emits buildings in block order and its block
+    // table becomes the grid; scattered buildings are sorted into XZ cells, which
+    // reorders them, so either way this runs before any buffers are built.
+    if (options.roads) {
+        CityLayout layout;
+        generateRoadCity(scene.buildings, options.numBuildings, options.seed, &pool, layout);
+        timings.generationMs = millisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        scene.grid = layoutSpatialGrid(layout, scene.buildings);
+        timings.indexMs = millisecondsSince(start);
+    } else {
+        generateCity(scene.buildings, options.numBuildings, options.seed, &pool);
+        timings.generationMs = millisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        scene.grid = buildSpatialGrid(scene.buildings, options.cellSize);
+        timings.indexMs = millisecondsSince(start);
+    }
+
+    GeometrySizes sizes = buildingGeometrySizes(scene.buildings.size(), scene.packedVertices);
+    timings.geometryBytes = options.instanced ? sizes.instanceBytes : sizes.vertexBytes;
+
+    if (options.saveSnapshot.empty()) {
+        // Bake straight into mapped GL buffers, the CPU never holds a full copy of the mesh
+        start = std::chrono::steady_clock::now();
+        if (options.instanced)
+            scene.instancedMesh = createInstancedMesh(scene.buildings, nullptr, &pool);
+        else
+            scene.buildingMesh = createBuildingMesh(scene.buildings, scene.packedVertices, nullptr, &pool);
+        timings.meshMs = millisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        createCullingData(scene, options);
+        glFinish();
+        timings.uploadMs = millisecondsSince(start);
+        timings.peakResidentBytes = peakResidentBytes();
+        return true;
+    }
+
+    // Saving needs CPU copies of both layouts so the snapshot serves either
+    start = std::chrono::steady_clock::now();
+    std::vector<float> vertices(buildingGeometrySizes(scene.buildings.size(), false).vertexBytes / sizeof(float));
+    std::vector<BuildingInstance> instances;
+    GeometryBuilder builder;
+    bakeBuildingVertices(builder, scene.buildings.data(), scene.buildings.size(), false, glm::vec3(0.0f),
+                         glm::vec3(1.0f), vertices.data(), &pool);
+    createInstanceData(scene.buildings, instances, &pool);
+    timings.meshMs = millisecondsSince(start);
+
+    if (!saveSnapshot(options.saveSnapshot.c_str(), options.seed, scene.buildings, scene.grid, vertices, instances))
+        return false;
+
+    start = std::chrono::steady_clock::now();
+    uploadCity(scene, vertices, instances);
+    createCullingData(scene, options);
+    glFinish();
+    timings.uploadMs = millisecondsSince(start);
+    timings.peakResidentBytes = peakResidentBytes();
+    return true;
+}
+
+// Draw per-level ranges, level 0 from the full mesh and the rest from the LOD proxies
+static void drawLevels(CityScene& scene, const std::vector<DrawRange> ranges[LOD_LEVELS]) {
+    if (scene.instanced)
+        drawInstancedMeshRanges(scene.instancedMesh, ranges[0]);
+    else
+        drawBuildingMeshRanges(scene.buildingMesh, ranges[0]);
+    drawLodProxies(scene.lod, ranges);
+}
+
+// Append grid cell c at the level its distance calls for
+static void appendCell(CityScene& scene, unsigned int c, const glm::vec3& cameraPos, std::vector<DrawRange> ranges[LOD_LEVELS]) {
+    const GridCell& cell = scene.grid.cells[c];
+    int level = selectCellLod(scene.lodSettings, cell, cameraPos);
+    if (level)
+        appendDrawRange(ranges[level], scene.lod.cellRanges[level - 1][c].first, scene.lod.cellRanges[level - 1][c].count);
+    else
+        appendDrawRange(ranges[0], cell.first, cell.count);
+}
+
+// Nearby cells and the ground fill the depth buffer, every other visible cell is
+// drawn only if its bounds pass the occlusion query issued against that depth
+static void drawOccludedCity(CityScene& scene, const Frustum& frustum, const glm::vec3& cameraPos) {
+    partitionOccluders(scene.occlusionCuller, scene.grid, frustum, cameraPos, scene.occluderCells, scene.occludeeCells);
+
+    for (int level = 0; level < LOD_LEVELS; level++)
+        scene.lodRanges[level].clear();
+    for (size_t i = 0; i < scene.occluderCells.size(); i++)
+        appendCell(scene, scene.occluderCells[i], cameraPos, scene.lodRanges);
+    for (size_t i = 0; i < scene.grid.oversized.size(); i++) {
+        const GridCell& cell = scene.grid.oversized[i];
+        if (boxInFrustum(frustum, cell.boundsMin, cell.boundsMax))
+            appendDrawRange(scene.lodRanges[0], cell.first, cell.count);
+    }
+    drawLevels(scene, scene.lodRanges);
+
+    issueOcclusionQueries(scene.occlusionCuller, scene.grid, scene.occludeeCells);
+    glUseProgram(scene.shaderProgram);
+
+    for (size_t i = 0; i < scene.occludeeCells.size(); i++) {
+        for (int level = 0; level < LOD_LEVELS; level++)
+            scene.lodRanges[level].clear();
+        appendCell(scene, scene.occludeeCells[i], cameraPos, scene.lodRanges);
+
+        beginOcclusionDraw(scene.occlusionCuller, scene.occludeeCells[i]);
+        drawLevels(scene, scene.lodRanges);
+        endOcclusionDraw();
+    }
+}
+
+void updateScene(CityScene& scene, const glm::vec3& cameraPos) {
+    PROFILE_SCOPE("update");
+    if (scene.world)
+        updateWorld(scene.streamingWorld, cameraPos);
+}
+
+void updateScene(CityScene& scene, const std::vector<glm::vec3>& cameraPositions) {
+    PROFILE_SCOPE("update");
+    if (scene.world)
+        updateWorld(scene.streamingWorld, cameraPositions);
+}
+
+unsigned int sceneRevision(const CityScene& scene) {
+    return scene.world ? scene.streamingWorld.revision : scene.revision;
+}
+
+bool sceneStreaming(const CityScene& scene) {
+    return scene.world && worldStreaming(scene.streamingWorld);
+}
+
+// Clear the bound framebuffer (or the scissor rectangle) and draw the city from one camera
+static void drawSceneView(CityScene& scene, const glm::vec3& cameraPos, const glm::vec3& cameraFront,
+                          const glm::mat4& projection) {
+    // Clear the screen
+    {
+        PROFILE_SCOPE("clear");
+        glClearColor(0.1f, 0.1f, 0.2f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    PROFILE_SCOPE("draw");
+
+    // Frame constants for every program, uploaded once
+    updateFrameUniforms(scene.frameUniforms, cameraPos, cameraFront, projection);
+    const Frustum& frustum = scene.frameUniforms.frustum;
+
+    // Activate shader
+    glUseProgram(scene.shaderProgram);
+
+    // Draw buildings
+    if (scene.world) {
+        // Thousands of chunk meshes: collect them, then submit sorted by state and distance
+        clearRenderQueue(scene.renderQueue);
+        queueWorld(scene.streamingWorld, frustum, cameraPos, scene.shaderProgram, scene.renderQueue);
+        submitRenderQueue(scene.renderQueue);
+    } else if (scene.gpuCull) {
+        runGpuCuller(scene.gpuCuller);
+        glUseProgram(scene.shaderProgram);
+        drawGpuCulled(scene.gpuCuller, scene.buildingMesh);
+    } else if (scene.occlusion) {
+        drawOccludedCity(scene, frustum, cameraPos);
+    } else if (scene.lodSettings.enabled) {
+        // Near cells at full detail, distant ones as merged blocks or single boxes
+        selectLod(scene.grid, scene.lod, scene.lodSettings, frustum, cameraPos, scene.lodRanges);
+        drawLevels(scene, scene.lodRanges);
+    } else if (scene.cull) {
+        // Submit only the grid cells inside the view frustum
+        cullSpatialGrid(scene.grid, frustum, scene.visibleRanges);
+        if (scene.instanced)
+            drawInstancedMeshRanges(scene.instancedMesh, scene.visibleRanges);
+        else
+            drawBuildingMeshRanges(scene.buildingMesh, scene.visibleRanges);
+    } else if (scene.instanced) {
+        drawInstancedMesh(scene.instancedMesh);
+    } else {
+        drawBuildingMesh(scene.buildingMesh);
+    }
+}
+
+void renderScene(CityScene& scene, const glm::vec3& cameraPos, const glm::vec3& cameraFront, float aspect) {
+    renderScene(scene, cameraPos, cameraFront, cameraProjection(aspect, scene.farPlane));
+}
+
+void renderScene(CityScene& scene, const glm::vec3& cameraPos, const glm::vec3& cameraFront,
+                 const glm::mat4& projection) {
+    drawSceneView(scene, cameraPos, cameraFront, projection);
+
+    // Fence this frame's staging writes
+    advanceStreamBuffer(scene.stream);
+}
+
+void renderScene(CityScene& scene, const std::vector<SceneView>& views) {
+    // The scissor keeps each view's clear inside its own rectangle
+    glEnable(GL_SCISSOR_TEST);
+    for (size_t i = 0; i < views.size(); i++) {
+        const SceneView& view = views[i];
+        if (view.width <= 0 || view.height <= 0)
+            continue;
+        glViewport(view.x, view.y, view.width, view.height);
+        glScissor(view.x, view.y, view.width, view.height);
+        drawSceneView(scene, view.cameraPos, view.cameraFront,
+                      cameraProjection((float)view.width / (float)view.height, scene.farPlane));
+    }
+    glDisable(GL_SCISSOR_TEST);
+
+    // All views wrote through the same ring, fence it once for the frame
+    advanceStreamBuffer(scene.stream);
+}
+
+void hashScene(const CityScene& scene, uint64_t& buildingsHash, uint64_t& geometryHash) {
+    buildingsHash = hashBuildings(scene.buildings);
+    if (scene.instanced)
+        geometryHash = hashBuildingInstances(scene.buildings);
+    else
+        geometryHash = hashBuildingVertices(scene.buildings, scene.packedVertices, scene.buildingMesh.quantOrigin,
+                                            scene.buildingMesh.quantScale);
+}
+
+void destroyScene(CityScene& scene) {
+    if (scene.world)
+        destroyWorld(scene.streamingWorld);
+    else if (scene.instanced)
+        destroyInstancedMesh(scene.instancedMesh);
+    else
+        destroyBuildingMesh(scene.buildingMesh);
+    destroyLodGeometry(scene.lod);
+    if (scene.gpuCull)
+        destroyGpuCuller(scene.gpuCuller);
+    if (scene.occlusion)
+        destroyOcclusionCuller(scene.occlusionCuller);
+    destroyStreamBuffer(scene.stream);
+    destroyFrameUniforms(scene.frameUniforms);
+    destroyMeshTransforms();
+    glDeleteProgram(scene.shaderProgram);
+}
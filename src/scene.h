@@ -0,0 +1,109 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "building_mesh.h"
+#include "city.h"
+#include "city_edit.h"
+#include "gpu_culling.h"
+#include "instancing.h"
+#include "lod.h"
+#include "occlusion.h"
+#include "options.h"
+#include "render_queue.h"
+#include "spatial_grid.h"
+#include "stream_buffer.h"
+#include "thread_pool.h"
+#include "uniform_buffers.h"
+#include "world.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Wall-clock cost of each startup stage in milliseconds
+struct SceneTimings {
+    double generationMs; // generateCity() or mapping a snapshot
+    double indexMs;      // spatial grid build
+    double meshMs;       // baking vertex/index or instance data on the CPU
+    double uploadMs;     // buffer creation and upload, up to glFinish()
+    size_t geometryBytes;     // vertex or instance bytes handed to GL
+    size_t peakResidentBytes; // process peak RSS once the scene is ready
+};
+
+// Everything needed to draw the city in the current GL context.
+// The streaming world keeps a pointer to stream, so a scene must not be copied.
+struct CityScene {
+    bool instanced;
+    bool cull;
+    bool world;
+    bool packedVertices;
+    float farPlane;
+    unsigned int shaderProgram;
+    FrameUniforms frameUniforms;
+    std::vector<Building> buildings;
+    SpatialGrid grid;
+    std::vector<DrawRange> visibleRanges;
+    BuildingMesh buildingMesh;
+    InstancedMesh instancedMesh;
+    LodSettings lodSettings;
+    LodGeometry lod;
+    std::vector<DrawRange> lodRanges[LOD_LEVELS];
+    bool occlusion;
+    OcclusionCuller occlusionCuller;
+    std::vector<unsigned int> occluderCells;
+    std::vector<unsigned int> occludeeCells;
+    bool gpuCull;
+    GpuCuller gpuCuller;
+    StreamBuffer stream;
+    StreamingWorld streamingWorld;
+    RenderQueue renderQueue;
+    CityEditState editState;
+    unsigned int revision; // bumped by every building edit
+};
+
+// One camera drawing into a rectangle of the current framebuffer
+struct SceneView {
+    glm::vec3 cameraPos;
+    glm::vec3 cameraFront;
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// Compile the program, generate (or load) the city and upload it
+bool createScene(const AppOptions& options, ThreadPool& pool, CityScene& scene, SceneTimings& timings);
+
+// Stream world chunks around the camera, nothing to do for a fixed city
+void updateScene(CityScene& scene, const glm::vec3& cameraPos);
+
+// Stream world chunks around every camera at once
+void updateScene(CityScene& scene, const std::vector<glm::vec3>& cameraPositions);
+
+// Changes whenever what the scene draws changes (edits, streamed chunks), so
+// an unchanged revision and camera mean the previous frame is still correct
+unsigned int sceneRevision(const CityScene& scene);
+
+// True while streamed chunks are still on their way in, i.e. the revision may
+// change without any input
+bool sceneStreaming(const CityScene& scene);
+
+// Clear and draw the city from the camera, then fence this frame's staging writes
+void renderScene(CityScene& scene, const glm::vec3& cameraPos, const glm::vec3& cameraFront, float aspect);
+
+// Same with an explicit projection matrix, e.g. one tile of a larger image
+void renderScene(CityScene& scene, const glm::vec3& cameraPos, const glm::vec3& cameraFront,
+                 const glm::mat4& projection);
+
+// Clear and draw every view into its rectangle from the same buffers, each with
+// its own frustum culling, LOD selection and occlusion pass, then fence once
+void renderScene(CityScene& scene, const std::vector<SceneView>& views);
+
+// Content hashes of the scene's buildings and of the vertex or instance bytes its
+// draw path uploads, stable for a given seed across runs and platforms
+void hashScene(const CityScene& scene, uint64_t& buildingsHash, uint64_t& geometryHash);
+
+void destroyScene(CityScene& scene);
+
+#endif
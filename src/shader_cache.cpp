@@ -0,0 +1,148 @@
+#include "shader_cache.h"
+#include "content_hash.h"
+#include "gl_extensions.h"
+
+#include <glad/glad.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// File layout: magic, layout version, key, binary format, byte count, then the driver's blob
+static const char SHADER_CACHE_MAGIC[4] = { 'C', 'S', 'P', 'B' };
+static const uint32_t SHADER_CACHE_VERSION = 1;
+
+struct ShaderCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t length;
+};
+
+static std::string cacheDirectory;
+
+static std::string cachePath(uint64_t key) {
+    return cacheDirectory + "/" + hashString(key) + ".bin";
+}
+
+static bool cacheUsable() {
+    return !cacheDirectory.empty() && glExtensions.programBinary;
+}
+
+void setShaderCacheDirectory(const std::string& directory) {
+    cacheDirectory = directory;
+}
+
+static uint64_t hashText(const char* text, uint64_t seed) {
+    return hashBytes(text ? text : "", text ? std::strlen(text) : 0, seed);
+}
+
+uint64_t shaderCacheKey(const char* vertexSource, const char* fragmentSource, const char* computeSource) {
+    // Binaries are only valid for the driver that produced them
+    uint64_t key = hashText((const char*)glGetString(GL_VENDOR), SHADER_CACHE_VERSION);
+    key = hashText((const char*)glGetString(GL_RENDERER), key);
+    key = hashText((const char*)glGetString(GL_VERSION), key);
+
+    // Stage tags keep a source from hashing the same in a different slot
+    key = hashText(vertexSource, key ^ 1);
+    key = hashText(fragmentSource, key ^ 2);
+    return hashText(computeSource, key ^ 3);
+}
+
+unsigned int loadCachedProgram(uint64_t key) {
+    if (!cacheUsable())
+        return 0;
+
+    std::ifstream file(cachePath(key).c_str(), std::ios::binary);
+    if (!file)
+        return 0;
+
+    ShaderCacheHeader header;
+    if (!file.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, SHADER_CACHE_MAGIC, 4) != 0 ||
+        header.version != SHADER_CACHE_VERSION || header.key != key || header.length == 0)
+        return 0;
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size()))
+        return 0;
+
+    // Drivers may refuse a binary at any time (format retired, GPU swapped), the caller recompiles
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, binary.data(), header.length);
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void prepareCachedProgram(unsigned int program) {
+    if (cacheUsable())
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+static bool makeDirectory(const std::string& path) {
+#if defined(_WIN32)
+    return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+void storeCachedProgram(uint64_t key, unsigned int program) {
+    if (!cacheUsable())
+        return;
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    ShaderCacheHeader header;
+    std::memcpy(header.magic, SHADER_CACHE_MAGIC, 4);
+    header.version = SHADER_CACHE_VERSION;
+    header.key = key;
+    std::vector<char> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0)
+        return;
+    header.binaryFormat = format;
+    header.length = written;
+
+    if (!makeDirectory(cacheDirectory)) {
+        std::cerr << "ERROR::SHADER_CACHE::DIRECTORY_FAILED " << cacheDirectory << std::endl;
+        return;
+    }
+
+    // Write next to the entry and rename, so a concurrent or interrupted run never reads half a file
+    std::string path = cachePath(key);
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        if (!file)
+            return;
+        file.write((const char*)&header, sizeof(header));
+        file.write(binary.data(), written);
+        if (!file) {
+            file.close();
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        std::remove(temporary.c_str());
+}
@@ -0,0 +1,28 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+// On-disk cache of linked programs (glGetProgramBinary / glProgramBinary).
+// Entries are keyed by a hash of the GL vendor, renderer and version strings
+// and every stage's source, so a driver update or a shader edit simply misses
+// and the caller compiles from source again. Needs glExtensions.programBinary;
+// without it every lookup misses and nothing is written.
+
+// Directory holding the cache files, created on first store. Empty disables the cache.
+void setShaderCacheDirectory(const std::string& directory);
+
+// Key for a program built from the given sources (null stages skipped)
+uint64_t shaderCacheKey(const char* vertexSource, const char* fragmentSource, const char* computeSource);
+
+// Linked program restored from the cache, 0 on a miss or when the driver rejects the binary
+unsigned int loadCachedProgram(uint64_t key);
+
+// Call on a new program before glLinkProgram so the driver keeps its binary around
+void prepareCachedProgram(unsigned int program);
+
+// Write a successfully linked program to the cache, failures only cost the next startup
+void storeCachedProgram(uint64_t key, unsigned int program);
+
+#endif
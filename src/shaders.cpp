@@ -0,0 +1,278 @@
+#include "shaders.h"
+
+#include "gl_extensions.h"
+#include "shader_cache.h"
+#include "uniform_buffers.h"
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+// Frame constants shared by every program, laid out as FrameUniformData
+#define FRAME_UNIFORM_BLOCK                     \
+    "layout (std140) uniform FrameUniforms {\n" \
+    "    mat4 view;\n"                          \
+    "    mat4 projection;\n"                    \
+    "    mat4 viewProjection;\n"                \
+    "    vec4 cameraPos;\n"                     \
+    "    vec4 frustumPlanes[6];\n"              \
+    "};\n"
+
+// Shader source code
+const char* vertexShaderSource = "#version 330 core\n" FRAME_UNIFORM_BLOCK R"(
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+out vec3 FragColor;
+
+void main()
+{
+    gl_Position = viewProjection * vec4(aPos, 1.0);
+    FragColor = aColor;
+}
+)";
+
+// Instanced variant: aPos is a unit cube corner in [-0.5, 0.5], scaled and
+// translated per building. Top corners get the same +0.1 brightening that
+// createBuildingBuffers() bakes on the CPU.
+const char* instancedVertexShaderSource = "#version 330 core\n" FRAME_UNIFORM_BLOCK R"(
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aOffset;
+layout (location = 2) in vec3 aScale;
+layout (location = 3) in vec3 aColor;
+
+out vec3 FragColor;
+
+void main()
+{
+    vec3 worldPos = aOffset + aPos * aScale;
+    gl_Position = viewProjection * vec4(worldPos, 1.0);
+    FragColor = aColor + (aPos.y > 0.0 ? vec3(0.1) : vec3(0.0));
+}
+)";
+
+// Packed variant for PackedBuildingVertex: normalized positions inside the
+// mesh bounds, base color in rgb and the top corner flag in alpha. The bounds
+// come from the mesh's slot in the shared transform buffer.
+const char* packedVertexShaderSource = "#version 330 core\n" FRAME_UNIFORM_BLOCK R"(
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aColor;
+
+out vec3 FragColor;
+
+layout (std140) uniform MeshTransform {
+    vec4 meshOrigin;
+    vec4 meshScale;
+};
+
+void main()
+{
+    gl_Position = viewProjection * vec4(meshOrigin.xyz + aPos * meshScale.xyz, 1.0);
+    FragColor = aColor.rgb + vec3(0.1 * aColor.a);
+}
+)";
+
+// Occlusion test proxy: a unit cube stretched over one grid cell's bounds
+const char* occlusionBoxVertexSource = "#version 330 core\n" FRAME_UNIFORM_BLOCK R"(
+layout (location = 0) in vec3 aPos;
+
+out vec3 FragColor;
+
+uniform vec3 boundsMin;
+uniform vec3 boundsMax;
+
+void main()
+{
+    gl_Position = viewProjection * vec4(mix(boundsMin, boundsMax, aPos + 0.5), 1.0);
+    FragColor = vec3(0.0);
+}
+)";
+
+// GPU culling (GL 4.3). Both test boxes against this frame's frustum planes
+// in FrameUniforms: the box is outside if its most positive corner along a
+// plane normal is behind that plane.
+
+// Instanced path: copy visible BuildingInstance records (9 floats) into a
+// compacted buffer, counting them in the instanceCount of one indirect command
+const char* cullInstancesComputeSource = "#version 430 core\n" FRAME_UNIFORM_BLOCK R"(
+layout (local_size_x = 64) in;
+
+layout (std430, binding = 0) readonly buffer Instances { float instances[]; };
+layout (std430, binding = 1) writeonly buffer Visible { float visible[]; };
+layout (std430, binding = 2) buffer Command { uint command[5]; };
+
+uniform uint itemCount;
+
+bool boxVisible(vec3 boundsMin, vec3 boundsMax)
+{
+    for (int i = 0; i < 6; i++) {
+        vec3 corner = mix(boundsMin, boundsMax, greaterThanEqual(frustumPlanes[i].xyz, vec3(0.0)));
+        if (dot(frustumPlanes[i].xyz, corner) + frustumPlanes[i].w < 0.0)
+            return false;
+    }
+    return true;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= itemCount)
+        return;
+
+    uint base = i * 9u;
+    vec3 offset = vec3(instances[base], instances[base + 1u], instances[base + 2u]);
+    vec3 extent = 0.5 * vec3(instances[base + 3u], instances[base + 4u], instances[base + 5u]);
+    if (!boxVisible(offset - extent, offset + extent))
+        return;
+
+    uint slot = atomicAdd(command[1], 1u) * 9u;
+    for (uint k = 0u; k < 9u; k++)
+        visible[slot + k] = instances[base + k];
+}
+)";
+
+// Baked path: one prefilled indirect command per grid cell, the shader only
+// switches each command's instanceCount between 0 and 1
+const char* cullCellsComputeSource = "#version 430 core\n" FRAME_UNIFORM_BLOCK R"(
+layout (local_size_x = 64) in;
+
+layout (std430, binding = 0) readonly buffer Bounds { vec4 bounds[]; }; // min, max per cell
+layout (std430, binding = 2) buffer Commands { uint commands[]; };      // 5 uints per cell
+
+uniform uint itemCount;
+
+bool boxVisible(vec3 boundsMin, vec3 boundsMax)
+{
+    for (int i = 0; i < 6; i++) {
+        vec3 corner = mix(boundsMin, boundsMax, greaterThanEqual(frustumPlanes[i].xyz, vec3(0.0)));
+        if (dot(frustumPlanes[i].xyz, corner) + frustumPlanes[i].w < 0.0)
+            return false;
+    }
+    return true;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= itemCount)
+        return;
+
+    commands[i * 5u + 1u] = boxVisible(bounds[i * 2u].xyz, bounds[i * 2u + 1u].xyz) ? 1u : 0u;
+}
+)";
+
+const char* fragmentShaderSource = R"(
+#version 330 core
+in vec3 FragColor;
+out vec4 FragOutput;
+
+void main()
+{
+    FragOutput = vec4(FragColor, 1.0);
+}
+)";
+
+unsigned int compileShaders() {
+    return compileShaderProgram(vertexShaderSource, fragmentShaderSource);
+}
+
+unsigned int compileShaderProgram(const char* vertexSource, const char* fragmentSource) {
+    // A binary from an earlier run skips compiling and linking entirely
+    uint64_t cacheKey = shaderCacheKey(vertexSource, fragmentSource, NULL);
+    if (unsigned int cached = loadCachedProgram(cacheKey)) {
+        bindUniformBlocks(cached);
+        return cached;
+    }
+
+    // Vertex shader
+    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexSource, NULL);
+    glCompileShader(vertexShader);
+
+    // Check for vertex shader compile errors
+    int success;
+    char infoLog[512];
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        return 0;
+    }
+
+    // Fragment shader
+    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
+    glCompileShader(fragmentShader);
+
+    // Check for fragment shader compile errors
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+        return 0;
+    }
+
+    // Link shaders
+    unsigned int shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    prepareCachedProgram(shaderProgram);
+    glLinkProgram(shaderProgram);
+
+    // Check for linking errors
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        return 0;
+    }
+
+    // Delete shaders as they're linked into program and no longer necessary
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    storeCachedProgram(cacheKey, shaderProgram);
+    bindUniformBlocks(shaderProgram);
+
+    return shaderProgram;
+}
+
+unsigned int compileComputeProgram(const char* computeSource) {
+    uint64_t cacheKey = shaderCacheKey(NULL, NULL, computeSource);
+    if (unsigned int cached = loadCachedProgram(cacheKey)) {
+        bindUniformBlocks(cached);
+        return cached;
+    }
+
+    unsigned int computeShader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(computeShader, 1, &computeSource, NULL);
+    glCompileShader(computeShader);
+
+    int success;
+    char infoLog[512];
+    glGetShaderiv(computeShader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(computeShader, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+        glDeleteShader(computeShader);
+        return 0;
+    }
+
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, computeShader);
+    prepareCachedProgram(program);
+    glLinkProgram(program);
+    glDeleteShader(computeShader);
+
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    storeCachedProgram(cacheKey, program);
+    bindUniformBlocks(program);
+    return program;
+}
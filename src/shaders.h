@@ -0,0 +1,22 @@
+#ifndef SHADERS_H
+#define SHADERS_H
+
+// Shader source code
+extern const char* vertexShaderSource;
+extern const char* fragmentShaderSource;
+extern const char* instancedVertexShaderSource;
+extern const char* packedVertexShaderSource;
+extern const char* occlusionBoxVertexSource;
+extern const char* cullInstancesComputeSource;
+extern const char* cullCellsComputeSource;
+
+// Compile and link the default (pre-baked vertex) program
+unsigned int compileShaders();
+
+// Compile and link a program from vertex and fragment sources, returns 0 on failure
+unsigned int compileShaderProgram(const char* vertexSource, const char* fragmentSource);
+
+// Compile and link a compute program (GL 4.3), returns 0 on failure
+unsigned int compileComputeProgram(const char* computeSource);
+
+#endif
@@ -0,0 +1,243 @@
+#include "snapshot.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char SNAPSHOT_MAGIC[8] = { 'C', 'I', 'T', 'Y', 'S', 'N', 'A', 'P' };
+static const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+static const uint64_t SNAPSHOT_ALIGNMENT = 64;
+// Interleaved vertices of one building in the vertex blob
+static const uint64_t SNAPSHOT_BUILDING_VERTICES = 8;
+
+static uint64_t alignOffset(uint64_t offset) {
+    return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(SNAPSHOT_ALIGNMENT - 1);
+}
+
+// Lay sections out back to back after the header
+static SnapshotSection placeSection(uint64_t& cursor, uint64_t size) {
+    SnapshotSection section;
+    section.offset = alignOffset(cursor);
+    section.size = size;
+    cursor = section.offset + size;
+    return section;
+}
+
+// Pad from position up to the section offset, then write its bytes
+static bool writeSection(std::FILE* file, uint64_t& position, const SnapshotSection& section, const void* data) {
+    static const char padding[SNAPSHOT_ALIGNMENT] = { 0 };
+    size_t pad = section.offset - position;
+    if (pad && std::fwrite(padding, 1, pad, file) != pad)
+        return false;
+    if (section.size && std::fwrite(data, 1, section.size, file) != section.size)
+        return false;
+    position = section.offset + section.size;
+    return true;
+}
+
+bool saveSnapshot(const char* path, unsigned int seed, const std::vector<Building>& buildings,
+                  const SpatialGrid& grid, const std::vector<float>& vertices,
+                  const std::vector<BuildingInstance>& instances) {
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.buildingSize = sizeof(Building);
+    header.cellSize = sizeof(GridCell);
+    header.instanceSize = sizeof(BuildingInstance);
+    header.vertexStride = 6 * sizeof(float);
+    header.seed = seed;
+    header.columns = grid.columns;
+    header.rows = grid.rows;
+    header.gridCellSize = grid.cellSize;
+    header.originX = grid.originX;
+    header.originZ = grid.originZ;
+
+    uint64_t cursor = sizeof(SnapshotHeader);
+    header.buildings = placeSection(cursor, buildings.size() * sizeof(Building));
+    header.cells = placeSection(cursor, grid.cells.size() * sizeof(GridCell));
+    header.oversized = placeSection(cursor, grid.oversized.size() * sizeof(GridCell));
+    header.vertices = placeSection(cursor, vertices.size() * sizeof(float));
+    header.instances = placeSection(cursor, instances.size() * sizeof(BuildingInstance));
+
+    std::FILE* file = std::fopen(path, "wb");
+    if (!file) {
+        std::cerr << "ERROR::SNAPSHOT::OPEN_FAILED " << path << std::endl;
+        return false;
+    }
+
+    uint64_t position = sizeof(header);
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+        && writeSection(file, position, header.buildings, buildings.data())
+        && writeSection(file, position, header.cells, grid.cells.data())
+        && writeSection(file, position, header.oversized, grid.oversized.data())
+        && writeSection(file, position, header.vertices, vertices.data())
+        && writeSection(file, position, header.instances, instances.data());
+    ok = std::fclose(file) == 0 && ok;
+
+    if (!ok)
+        std::cerr << "ERROR::SNAPSHOT::WRITE_FAILED " << path << std::endl;
+    return ok;
+}
+
+static bool mapFile(const char* path, void*& mapping, size_t& size) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE view = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!view)
+        return false;
+    mapping = MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(view);
+    size = (size_t)fileSize.QuadPart;
+    return mapping != NULL;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    size = (size_t)info.st_size;
+    mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        return false;
+    }
+    // Blobs are read front to back once by glBufferData
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    return true;
+#endif
+}
+
+static void unmapFile(void* mapping, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, size);
+#endif
+}
+
+static bool sectionFits(const SnapshotSection& section, size_t fileSize, uint32_t recordSize) {
+    return section.offset <= fileSize && section.size <= fileSize - section.offset
+        && section.offset % SNAPSHOT_ALIGNMENT == 0 && section.size % recordSize == 0;
+}
+
+// Exactly count records, compared by division so a huge count can't wrap
+static bool sectionHolds(const SnapshotSection& section, uint64_t count, uint64_t recordSize) {
+    return section.size % recordSize == 0 && section.size / recordSize == count;
+}
+
+// Every cell's building range has to lie inside the buildings section
+static bool cellsFit(const unsigned char* base, const SnapshotSection& section, uint64_t buildingCount) {
+    const GridCell* cells = (const GridCell*)(base + section.offset);
+    size_t count = section.size / sizeof(GridCell);
+    for (size_t i = 0; i < count; i++) {
+        if (cells[i].first > buildingCount || cells[i].count > buildingCount - cells[i].first)
+            return false;
+    }
+    return true;
+}
+
+bool openSnapshot(const char* path, CitySnapshot& snapshot) {
+    std::memset(&snapshot, 0, sizeof(snapshot));
+
+    void* mapping = nullptr;
+    size_t size = 0;
+    if (!mapFile(path, mapping, size)) {
+        std::cerr << "ERROR::SNAPSHOT::MAP_FAILED " << path << std::endl;
+        return false;
+    }
+
+    const SnapshotHeader* header = (const SnapshotHeader*)mapping;
+    const char* error = nullptr;
+    if (size < sizeof(SnapshotHeader) || std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0)
+        error = "ERROR::SNAPSHOT::NOT_A_SNAPSHOT";
+    else if (header->version != SNAPSHOT_VERSION)
+        error = "ERROR::SNAPSHOT::UNSUPPORTED_VERSION";
+    else if (header->byteOrder != SNAPSHOT_BYTE_ORDER || header->buildingSize != sizeof(Building)
+             || header->cellSize != sizeof(GridCell) || header->instanceSize != sizeof(BuildingInstance)
+             || header->vertexStride != 6 * sizeof(float))
+        error = "ERROR::SNAPSHOT::LAYOUT_MISMATCH";
+    else if (!sectionFits(header->buildings, size, sizeof(Building))
+             || !sectionFits(header->cells, size, sizeof(GridCell))
+             || !sectionFits(header->oversized, size, sizeof(GridCell))
+             || !sectionFits(header->vertices, size, header->vertexStride)
+             || !sectionFits(header->instances, size, sizeof(BuildingInstance))
+             || header->columns < 0 || header->rows < 0)
+        error = "ERROR::SNAPSHOT::CORRUPT";
+    else {
+        // Draws cover every building, so each blob and cell range has to match the building count
+        uint64_t buildingCount = header->buildings.size / sizeof(Building);
+        if (!sectionHolds(header->cells, (uint64_t)header->columns * (uint64_t)header->rows, sizeof(GridCell))
+            || !sectionHolds(header->vertices, buildingCount, SNAPSHOT_BUILDING_VERTICES * header->vertexStride)
+            || !sectionHolds(header->instances, buildingCount, sizeof(BuildingInstance))
+            || !cellsFit((const unsigned char*)mapping, header->cells, buildingCount)
+            || !cellsFit((const unsigned char*)mapping, header->oversized, buildingCount))
+            error = "ERROR::SNAPSHOT::CORRUPT";
+    }
+
+    if (error) {
+        std::cerr << error << " " << path << std::endl;
+        unmapFile(mapping, size);
+        return false;
+    }
+
+    const unsigned char* base = (const unsigned char*)mapping;
+    snapshot.mapping = mapping;
+    snapshot.mappingSize = size;
+    snapshot.header = header;
+    snapshot.buildings = (const Building*)(base + header->buildings.offset);
+    snapshot.buildingCount = header->buildings.size / sizeof(Building);
+    snapshot.vertices = (const float*)(base + header->vertices.offset);
+    snapshot.vertexFloats = header->vertices.size / sizeof(float);
+    snapshot.instances = (const BuildingInstance*)(base + header->instances.offset);
+    snapshot.instanceCount = header->instances.size / sizeof(BuildingInstance);
+    return true;
+}
+
+SpatialGrid snapshotGrid(const CitySnapshot& snapshot) {
+    const SnapshotHeader* header = snapshot.header;
+    const unsigned char* base = (const unsigned char*)snapshot.mapping;
+    const GridCell* cells = (const GridCell*)(base + header->cells.offset);
+    const GridCell* oversized = (const GridCell*)(base + header->oversized.offset);
+
+    SpatialGrid grid;
+    grid.cellSize = header->gridCellSize;
+    grid.originX = header->originX;
+    grid.originZ = header->originZ;
+    grid.columns = header->columns;
+    grid.rows = header->rows;
+    grid.cells.assign(cells, cells + header->cells.size / sizeof(GridCell));
+    grid.oversized.assign(oversized, oversized + header->oversized.size / sizeof(GridCell));
+    return grid;
+}
+
+void closeSnapshot(CitySnapshot& snapshot) {
+    if (snapshot.mapping)
+        unmapFile(snapshot.mapping, snapshot.mappingSize);
+    std::memset(&snapshot, 0, sizeof(snapshot));
+}
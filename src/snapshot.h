@@ -0,0 +1,72 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "city.h"
+#include "instancing.h"
+#include "spatial_grid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bump whenever the layout of the header or of any record changes
+static const uint32_t SNAPSHOT_VERSION = 2;
+
+// Byte range of one blob inside the file, offsets are 64-byte aligned
+struct SnapshotSection {
+    uint64_t offset;
+    uint64_t size;
+};
+
+// File header. Every section is a raw array of the in-memory record type, so a
+// mapped file can be handed straight to glBufferData without parsing.
+struct SnapshotHeader {
+    char magic[8];          // "CITYSNAP"
+    uint32_t version;
+    uint32_t byteOrder;     // 0x01020304 as written by the saving machine
+    uint32_t buildingSize;  // sizeof(Building), sizeof(GridCell), ... as a layout check
+    uint32_t cellSize;
+    uint32_t instanceSize;
+    uint32_t vertexStride;  // bytes per interleaved vertex
+    uint32_t seed;
+    int32_t columns;
+    int32_t rows;
+    float gridCellSize;
+    float originX;
+    float originZ;
+    SnapshotSection buildings;  // Building[], already in spatial grid order
+    SnapshotSection cells;      // GridCell[columns * rows]
+    SnapshotSection oversized;  // GridCell[]
+    SnapshotSection vertices;   // float[48 * buildingCount], 8 vertices per building
+    SnapshotSection instances;  // BuildingInstance[buildingCount]
+};
+
+// Read-only view of a mapped snapshot, pointers point into the mapping
+struct CitySnapshot {
+    void* mapping;
+    size_t mappingSize;
+    const SnapshotHeader* header;
+    const Building* buildings;
+    size_t buildingCount;
+    const float* vertices;
+    size_t vertexFloats;
+    const BuildingInstance* instances;
+    size_t instanceCount;
+};
+
+// Write buildings (in grid order), the grid and the GPU-ready blobs to path.
+// Meshes share one index pattern built at load, so no index blob is stored.
+bool saveSnapshot(const char* path, unsigned int seed, const std::vector<Building>& buildings,
+                  const SpatialGrid& grid, const std::vector<float>& vertices,
+                  const std::vector<BuildingInstance>& instances);
+
+// Map path read-only and validate the header, the section bounds and that every
+// section and grid cell matches the building count
+bool openSnapshot(const char* path, CitySnapshot& snapshot);
+
+// Rebuild the (small) grid cell tables from a mapped snapshot
+SpatialGrid snapshotGrid(const CitySnapshot& snapshot);
+
+void closeSnapshot(CitySnapshot& snapshot);
+
+#endif
@@ -0,0 +1,162 @@
+#include "spatial_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+Frustum extractFrustum(const glm::mat4& m) {
+    // Gribb/Hartmann: combine rows of the column-major matrix
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum frustum;
+    frustum.planes[0] = row3 + row0; // Left
+    frustum.planes[1] = row3 - row0; // Right
+    frustum.planes[2] = row3 + row1; // Bottom
+    frustum.planes[3] = row3 - row1; // Top
+    frustum.planes[4] = row3 + row2; // Near
+    frustum.planes[5] = row3 - row2; // Far
+    return frustum;
+}
+
+bool boxInFrustum(const Frustum& frustum, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    for (int i = 0; i < 6; i++) {
+        const glm::vec4& p = frustum.planes[i];
+
+        // Corner furthest along the plane normal
+        glm::vec3 corner(p.x >= 0.0f ? boundsMax.x : boundsMin.x,
+                         p.y >= 0.0f ? boundsMax.y : boundsMin.y,
+                         p.z >= 0.0f ? boundsMax.z : boundsMin.z);
+        if (p.x * corner.x + p.y * corner.y + p.z * corner.z + p.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+void buildingBounds(const Building& b, glm::vec3& boundsMin, glm::vec3& boundsMax) {
+    glm::vec3 half(b.width / 2.0f, b.height / 2.0f, b.depth / 2.0f);
+    boundsMin = b.position - half;
+    boundsMax = b.position + half;
+}
+
+SpatialGrid buildSpatialGrid(std::vector<Building>& buildings, float cellSize) {
+    SpatialGrid grid;
+    grid.cellSize = cellSize;
+    grid.originX = 0.0f;
+    grid.originZ = 0.0f;
+    grid.columns = 0;
+    grid.rows = 0;
+
+    if (buildings.empty())
+        return grid;
+
+    // Extent of building centers, oversized buildings don't belong to a cell
+    float minX = 0.0f, maxX = 0.0f, minZ = 0.0f, maxZ = 0.0f;
+    bool first = true;
+    for (size_t i = 0; i < buildings.size(); i++) {
+        const Building& b = buildings[i];
+        if (b.width > cellSize || b.depth > cellSize)
+            continue;
+        if (first) {
+            minX = maxX = b.position.x;
+            minZ = maxZ = b.position.z;
+            first = false;
+        }
+        minX = std::min(minX, b.position.x);
+        maxX = std::max(maxX, b.position.x);
+        minZ = std::min(minZ, b.position.z);
+        maxZ = std::max(maxZ, b.position.z);
+    }
+
+    grid.originX = minX;
+    grid.originZ = minZ;
+    grid.columns = first ? 0 : (int)std::floor((maxX - minX) / cellSize) + 1;
+    grid.rows = first ? 0 : (int)std::floor((maxZ - minZ) / cellSize) + 1;
+
+    // Cell key per building, oversized ones sort after every cell
+    size_t cellCount = (size_t)grid.columns * grid.rows;
+    std::vector<unsigned int> keys(buildings.size());
+    std::vector<unsigned int> counts(cellCount + 1, 0);
+    for (size_t i = 0; i < buildings.size(); i++) {
+        const Building& b = buildings[i];
+        unsigned int key = cellCount;
+        if (b.width <= cellSize && b.depth <= cellSize) {
+            int cx = std::min((int)((b.position.x - minX) / cellSize), grid.columns - 1);
+            int cz = std::min((int)((b.position.z - minZ) / cellSize), grid.rows - 1);
+            key = cz * grid.columns + cx;
+        }
+        keys[i] = key;
+        counts[key]++;
+    }
+
+    // Counting sort keeps the original order inside each cell
+    std::vector<unsigned int> offsets(cellCount + 1, 0);
+    for (size_t c = 1; c <= cellCount; c++)
+        offsets[c] = offsets[c - 1] + counts[c - 1];
+
+    grid.cells.resize(cellCount);
+    for (size_t c = 0; c < cellCount; c++) {
+        grid.cells[c].first = offsets[c];
+        grid.cells[c].count = counts[c];
+        grid.cells[c].boundsMin = glm::vec3(0.0f);
+        grid.cells[c].boundsMax = glm::vec3(0.0f);
+    }
+
+    std::vector<Building> sorted(buildings.size());
+    for (size_t i = 0; i < buildings.size(); i++)
+        sorted[offsets[keys[i]]++] = buildings[i];
+    buildings.swap(sorted);
+
+    // Cell bounds are the union of their buildings, so boxes straddling a cell edge stay conservative
+    for (size_t c = 0; c < cellCount; c++) {
+        GridCell& cell = grid.cells[c];
+        for (unsigned int i = cell.first; i < cell.first + cell.count; i++) {
+            glm::vec3 bMin, bMax;
+            buildingBounds(buildings[i], bMin, bMax);
+            if (i == cell.first) {
+                cell.boundsMin = bMin;
+                cell.boundsMax = bMax;
+            } else {
+                cell.boundsMin = glm::min(cell.boundsMin, bMin);
+                cell.boundsMax = glm::max(cell.boundsMax, bMax);
+            }
+        }
+    }
+
+    unsigned int oversizedFirst = buildings.size() - counts[cellCount];
+    for (unsigned int i = oversizedFirst; i < buildings.size(); i++) {
+        GridCell cell;
+        buildingBounds(buildings[i], cell.boundsMin, cell.boundsMax);
+        cell.first = i;
+        cell.count = 1;
+        grid.oversized.push_back(cell);
+    }
+
+    return grid;
+}
+
+void appendDrawRange(std::vector<DrawRange>& ranges, unsigned int first, unsigned int count) {
+    if (!ranges.empty() && ranges.back().first + ranges.back().count == first) {
+        ranges.back().count += count;
+        return;
+    }
+    DrawRange range;
+    range.first = first;
+    range.count = count;
+    ranges.push_back(range);
+}
+
+void cullSpatialGrid(const SpatialGrid& grid, const Frustum& frustum, std::vector<DrawRange>& ranges) {
+    ranges.clear();
+    for (size_t c = 0; c < grid.cells.size(); c++) {
+        const GridCell& cell = grid.cells[c];
+        if (cell.count && boxInFrustum(frustum, cell.boundsMin, cell.boundsMax))
+            appendDrawRange(ranges, cell.first, cell.count);
+    }
+    for (size_t c = 0; c < grid.oversized.size(); c++) {
+        const GridCell& cell = grid.oversized[c];
+        if (boxInFrustum(frustum, cell.boundsMin, cell.boundsMax))
+            appendDrawRange(ranges, cell.first, cell.count);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include "city.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// View frustum as six inward-facing planes (xyz = normal, w = distance)
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// Extract the frustum planes from a projection * view matrix
+Frustum extractFrustum(const glm::mat4& viewProjection);
+
+// Conservative box test, true if any part of the box may be visible
+bool boxInFrustum(const Frustum& frustum, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+// Axis-aligned bounds of a building box
+void buildingBounds(const Building& building, glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+// Contiguous run of buildings (or instances) to submit in one draw
+struct DrawRange {
+    unsigned int first;
+    unsigned int count;
+};
+
+// One grid cell, owning buildings [first, first + count)
+struct GridCell {
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    unsigned int first;
+    unsigned int count;
+};
+
+// Uniform grid over the XZ footprint of the city
+struct SpatialGrid {
+    float cellSize;
+    float originX;
+    float originZ;
+    int columns;
+    int rows;
+    std::vector<GridCell> cells;     // columns * rows, row-major, empty cells have count 0
+    std::vector<GridCell> oversized; // buildings wider than a cell (e.g. the ground), tested individually
+};
+
+// Sort buildings by cell so every cell owns a contiguous range, then build the grid.
+// Must run before any vertex, index or instance data is created from buildings.
+SpatialGrid buildSpatialGrid(std::vector<Building>& buildings, float cellSize);
+
+// Append a range, extending the last one when the two are contiguous
+void appendDrawRange(std::vector<DrawRange>& ranges, unsigned int first, unsigned int count);
+
+// Replace ranges with the building ranges of every cell intersecting the frustum,
+// merging neighbouring ranges so adjacent visible cells become one draw
+void cullSpatialGrid(const SpatialGrid& grid, const Frustum& frustum, std::vector<DrawRange>& ranges);
+
+#endif
@@ -0,0 +1,122 @@
+#include "stream_buffer.h"
+#include "gl_extensions.h"
+
+#include <cstring>
+
+// Keep reservations aligned for the vec3/float attribute data we copy
+static const size_t STREAM_ALIGNMENT = 16;
+
+StreamBuffer createStreamBuffer(size_t sectionSize, bool allowPersistent) {
+    StreamBuffer stream = StreamBuffer();
+    stream.sectionSize = (sectionSize + STREAM_ALIGNMENT - 1) & ~(STREAM_ALIGNMENT - 1);
+    stream.persistent = allowPersistent && glExtensions.bufferStorage;
+
+    size_t total = stream.sectionSize * STREAM_BUFFER_SECTIONS;
+    glGenBuffers(1, &stream.buffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, stream.buffer);
+
+    if (stream.persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_READ_BUFFER, total, NULL, flags);
+        stream.mapped = (unsigned char*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, total, flags);
+        if (!stream.mapped) {
+            // Storage is immutable now, recreate the buffer for the fallback path
+            glDeleteBuffers(1, &stream.buffer);
+            glGenBuffers(1, &stream.buffer);
+            glBindBuffer(GL_COPY_READ_BUFFER, stream.buffer);
+            stream.persistent = false;
+        }
+    }
+
+    if (!stream.persistent)
+        glBufferData(GL_COPY_READ_BUFFER, total, NULL, GL_STREAM_DRAW);
+
+    return stream;
+}
+
+void* mapStreamRange(StreamBuffer& stream, size_t bytes, size_t& ringOffset) {
+    if (bytes > stream.sectionSize)
+        return nullptr;
+    if (stream.offset + bytes > stream.sectionSize)
+        advanceStreamBuffer(stream);
+
+    ringOffset = stream.section * stream.sectionSize + stream.offset;
+    stream.offset = (stream.offset + bytes + STREAM_ALIGNMENT - 1) & ~(STREAM_ALIGNMENT - 1);
+
+    if (stream.persistent)
+        return stream.mapped + ringOffset;
+
+    // Sections behind us live in an orphaned store, so nothing here can be in use
+    glBindBuffer(GL_COPY_READ_BUFFER, stream.buffer);
+    return glMapBufferRange(GL_COPY_READ_BUFFER, ringOffset, bytes,
+                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+void unmapStreamRange(StreamBuffer& stream) {
+    if (stream.persistent)
+        return; // Coherent mapping, nothing to flush
+
+    glBindBuffer(GL_COPY_READ_BUFFER, stream.buffer);
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+}
+
+void streamUpload(StreamBuffer& stream, unsigned int dstBuffer, size_t dstOffset, const void* data, size_t bytes) {
+    const unsigned char* src = (const unsigned char*)data;
+    while (bytes > 0) {
+        size_t piece = bytes < stream.sectionSize ? bytes : stream.sectionSize;
+        size_t ringOffset = 0;
+        void* ptr = mapStreamRange(stream, piece, ringOffset);
+        if (!ptr)
+            return;
+        std::memcpy(ptr, src, piece);
+        unmapStreamRange(stream);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, stream.buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, dstBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, ringOffset, dstOffset, piece);
+
+        src += piece;
+        dstOffset += piece;
+        bytes -= piece;
+    }
+}
+
+void advanceStreamBuffer(StreamBuffer& stream) {
+    if (stream.persistent) {
+        stream.fences[stream.section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        stream.section = (stream.section + 1) % STREAM_BUFFER_SECTIONS;
+
+        // Wait only if the GPU hasn't finished with this section from frames ago
+        GLsync fence = stream.fences[stream.section];
+        if (fence) {
+            GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            while (result == GL_TIMEOUT_EXPIRED)
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            glDeleteSync(fence);
+            stream.fences[stream.section] = 0;
+        }
+    } else {
+        stream.section = (stream.section + 1) % STREAM_BUFFER_SECTIONS;
+
+        // Orphan on wrap so the driver hands us fresh storage instead of syncing
+        if (stream.section == 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, stream.buffer);
+            glBufferData(GL_COPY_READ_BUFFER, stream.sectionSize * STREAM_BUFFER_SECTIONS, NULL, GL_STREAM_DRAW);
+        }
+    }
+    stream.offset = 0;
+}
+
+void destroyStreamBuffer(StreamBuffer& stream) {
+    for (int i = 0; i < STREAM_BUFFER_SECTIONS; i++) {
+        if (stream.fences[i])
+            glDeleteSync(stream.fences[i]);
+        stream.fences[i] = 0;
+    }
+    if (stream.persistent) {
+        glBindBuffer(GL_COPY_READ_BUFFER, stream.buffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+    }
+    glDeleteBuffers(1, &stream.buffer);
+    stream.mapped = nullptr;
+}
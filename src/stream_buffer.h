@@ -0,0 +1,46 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// Ring sections, one per frame the GPU may still be reading
+static const int STREAM_BUFFER_SECTIONS = 3;
+
+// Triple-buffered staging ring for dynamic geometry. With GL_ARB_buffer_storage
+// the whole ring stays persistently mapped and each section is guarded by a
+// fence; otherwise ranges are mapped unsynchronized and the store is orphaned
+// every time the ring wraps.
+struct StreamBuffer {
+    unsigned int buffer;
+    size_t sectionSize;
+    int section;            // section currently being written
+    size_t offset;          // write offset inside the current section
+    bool persistent;
+    unsigned char* mapped;  // persistent mapping of the whole ring, null on the fallback path
+    GLsync fences[STREAM_BUFFER_SECTIONS];
+};
+
+// allowPersistent false forces the glMapBufferRange fallback
+StreamBuffer createStreamBuffer(size_t sectionSize, bool allowPersistent);
+
+// Reserve bytes in the current section, moving to the next one if it is full.
+// Returns a write pointer and the byte offset of the reservation inside the
+// ring, or nullptr if bytes is larger than a section.
+void* mapStreamRange(StreamBuffer& stream, size_t bytes, size_t& ringOffset);
+
+// Finish a write started by mapStreamRange()
+void unmapStreamRange(StreamBuffer& stream);
+
+// Copy bytes into dstBuffer at dstOffset through the ring with glCopyBufferSubData,
+// so the CPU never waits on draws still reading dstBuffer
+void streamUpload(StreamBuffer& stream, unsigned int dstBuffer, size_t dstOffset, const void* data, size_t bytes);
+
+// Call once per frame after the draws: fence the current section and move on,
+// blocking only if the GPU is still reading the section being reused
+void advanceStreamBuffer(StreamBuffer& stream);
+
+void destroyStreamBuffer(StreamBuffer& stream);
+
+#endif
@@ -0,0 +1,100 @@
+#include "thread_pool.h"
+
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int threadCount) : stopping(false) {
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0)
+        threadCount = 1;
+
+    for (unsigned int i = 0; i < threadCount; i++)
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+unsigned int ThreadPool::size() const {
+    return workers.size();
+}
+
+void ThreadPool::submit(const std::function<void()>& task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(task);
+    }
+    condition.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+                return;
+            task = tasks.front();
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+// Shared between the caller and the helper tasks of one parallelFor(); helpers
+// that start after every job was claimed just return, so the caller never waits on them
+struct ParallelForState {
+    std::atomic<size_t> next;
+    size_t count;
+    size_t completed;
+    std::function<void(size_t)> job;
+    std::mutex mutex;
+    std::condition_variable done;
+};
+
+static void drainJobs(ParallelForState& state) {
+    size_t finished = 0;
+    for (size_t i = state.next++; i < state.count; i = state.next++) {
+        state.job(i);
+        finished++;
+    }
+    if (!finished)
+        return;
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.completed += finished;
+    if (state.completed == state.count)
+        state.done.notify_all();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& job) {
+    if (count == 0)
+        return;
+
+    std::shared_ptr<ParallelForState> state(new ParallelForState());
+    state->next = 0;
+    state->count = count;
+    state->completed = 0;
+    state->job = job;
+
+    size_t helpers = workers.size();
+    if (helpers > count - 1)
+        helpers = count - 1;
+    for (size_t i = 0; i < helpers; i++)
+        submit([state] { drainJobs(*state); });
+
+    // The caller works too instead of just blocking
+    drainJobs(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state] { return state->completed == state->count; });
+}
@@ -0,0 +1,39 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads fed from one task queue
+class ThreadPool {
+public:
+    // threadCount 0 uses std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned int threadCount);
+    ~ThreadPool();
+
+    // Number of worker threads
+    unsigned int size() const;
+
+    // Queue a task for any worker
+    void submit(const std::function<void()>& task);
+
+    // Run job(i) for every i in [0, count) on the workers and the calling thread,
+    // returns once all jobs have finished
+    void parallelFor(size_t count, const std::function<void(size_t)>& job);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()> > tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "tile_render.h"
+#include "camera_path.h"
+#include "render_target.h"
+#include "scene.h"
+#include "thread_pool.h"
+#include "uniform_buffers.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Pixel buffers in flight: the tile just drawn, the ones still queued on the GPU and the one being copied out
+static const int TILE_READBACK_BUFFERS = 3;
+
+// One tile's trip from the render target to its row strip
+struct TileReadback {
+    unsigned int buffer; // GL_PIXEL_PACK_BUFFER of tileWidth * tileHeight RGBA8 pixels
+    GLsync fence;        // signaled once glReadPixels has filled buffer
+    int column;
+    int row;             // counted from the top of the image
+    int width;
+    int height;
+};
+
+// Block until the tile's pixels have landed in its buffer
+static bool waitForTile(TileReadback& tile) {
+    GLenum result = glClientWaitSync(tile.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (result == GL_TIMEOUT_EXPIRED)
+        result = glClientWaitSync(tile.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    glDeleteSync(tile.fence);
+    tile.fence = 0;
+    return result != GL_WAIT_FAILED;
+}
+
+// Copy a read back tile into its place in a strip of top-down RGB scanlines
+static bool copyTile(const TileReadback& tile, int tileWidth, int imageWidth, std::vector<unsigned char>& strip) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, tile.buffer);
+    const unsigned char* pixels = (const unsigned char*)glMapBufferRange(
+        GL_PIXEL_PACK_BUFFER, 0, (size_t)tile.width * tile.height * 4, GL_MAP_READ_BIT);
+    if (pixels) {
+        // GL rows run bottom up, the file top down
+        for (int y = 0; y < tile.height; y++) {
+            const unsigned char* source = pixels + (size_t)(tile.height - 1 - y) * tile.width * 4;
+            unsigned char* destination = &strip[((size_t)y * imageWidth + (size_t)tile.column * tileWidth) * 3];
+            for (int x = 0; x < tile.width; x++) {
+                destination[x * 3] = source[x * 4];
+                destination[x * 3 + 1] = source[x * 4 + 1];
+                destination[x * 3 + 2] = source[x * 4 + 2];
+            }
+        }
+    }
+    bool copied = pixels && glUnmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_TRUE;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return copied;
+}
+
+int runTileRender(const AppOptions& options, GLFWwindow* window) {
+    (void)window;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    CameraPath path;
+    if (!loadCameraPath(options.cameraPath, path)) return -1;
+    glm::vec3 cameraPos, cameraFront;
+    sampleCameraPath(path, 0.0f, cameraPos, cameraFront);
+
+    ThreadPool pool(options.threads);
+    CityScene scene;
+    SceneTimings timings;
+    if (!createScene(options, pool, scene, timings)) return -1;
+
+    int imageWidth = options.renderWidth;
+    int imageHeight = options.renderHeight;
+    int tileWidth = std::min(options.renderTile, imageWidth);
+    int tileHeight = std::min(options.renderTile, imageHeight);
+    int columns = (imageWidth + tileWidth - 1) / tileWidth;
+    int rows = (imageHeight + tileHeight - 1) / tileHeight;
+    int tileCount = columns * rows;
+
+    RenderTarget target = createRenderTarget(tileWidth, tileHeight);
+    std::ofstream file(options.renderOutput.c_str(), std::ios::binary);
+    if (!file)
+        std::cerr << "ERROR::RENDER::OPEN_FAILED " << options.renderOutput << std::endl;
+    bool ok = target.framebuffer && file;
+    file << "P6\n" << imageWidth << " " << imageHeight << "\n255\n";
+
+    TileReadback readbacks[TILE_READBACK_BUFFERS];
+    for (int i = 0; i < TILE_READBACK_BUFFERS; i++) {
+        readbacks[i] = TileReadback();
+        glGenBuffers(1, &readbacks[i].buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readbacks[i].buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)tileWidth * tileHeight * 4, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Rows of tiles alternate between two strips: one fills while the writer thread saves the other
+    std::vector<unsigned char> strips[2];
+    strips[0].resize((size_t)imageWidth * tileHeight * 3);
+    strips[1].resize((size_t)imageWidth * tileHeight * 3);
+    std::thread writer;
+    bool writeFailed = false;
+
+    // Every tile narrows the one full-image projection, so the tiles meet without seams
+    glm::mat4 projection = cameraProjection((float)imageWidth / (float)imageHeight, scene.farPlane);
+    int drawn = 0;
+    int copied = 0;
+    while (ok && copied < tileCount) {
+        // Keep the ring full so the GPU always has the next tiles queued
+        if (drawn < tileCount && drawn - copied < TILE_READBACK_BUFFERS) {
+            TileReadback& tile = readbacks[drawn % TILE_READBACK_BUFFERS];
+            tile.column = drawn % columns;
+            tile.row = drawn / columns;
+            int left = tile.column * tileWidth;
+            int top = tile.row * tileHeight;
+            tile.width = std::min(tileWidth, imageWidth - left);
+            tile.height = std::min(tileHeight, imageHeight - top);
+
+            bindRenderTarget(target);
+            glViewport(0, 0, tile.width, tile.height);
+            renderScene(scene, cameraPos, cameraFront,
+                        tileProjection(projection, imageWidth, imageHeight, left, imageHeight - top - tile.height,
+                                       tile.width, tile.height));
+
+            // Asynchronous copy into the tile's pixel buffer, fenced so it is only mapped once done
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, tile.buffer);
+            glReadPixels(0, 0, tile.width, tile.height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            tile.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            drawn++;
+            continue;
+        }
+
+        // Oldest tile in flight into its row's strip
+        TileReadback& tile = readbacks[copied % TILE_READBACK_BUFFERS];
+        std::vector<unsigned char>& strip = strips[tile.row % 2];
+        if (!waitForTile(tile) || !copyTile(tile, tileWidth, imageWidth, strip)) {
+            std::cerr << "ERROR::RENDER::READBACK_FAILED tile " << copied << std::endl;
+            ok = false;
+            break;
+        }
+        copied++;
+
+        // A finished row goes to disk once the previous one is written
+        if (tile.column == columns - 1) {
+            if (writer.joinable())
+                writer.join();
+            size_t bytes = (size_t)imageWidth * tile.height * 3;
+            writer = std::thread([&file, &strip, bytes, &writeFailed] {
+                if (!file.write((const char*)strip.data(), bytes))
+                    writeFailed = true;
+            });
+            std::cout << "Row " << tile.row + 1 << "/" << rows << std::endl;
+        }
+    }
+    if (writer.joinable())
+        writer.join();
+    if (ok && (writeFailed || !file.flush())) {
+        std::cerr << "ERROR::RENDER::WRITE_FAILED " << options.renderOutput << std::endl;
+        ok = false;
+    }
+
+    // Tiles abandoned mid-flight still hold fences
+    for (int i = 0; i < TILE_READBACK_BUFFERS; i++) {
+        if (readbacks[i].fence)
+            glDeleteSync(readbacks[i].fence);
+        glDeleteBuffers(1, &readbacks[i].buffer);
+    }
+    destroyRenderTarget(target);
+    destroyScene(scene);
+
+    if (!ok)
+        return -1;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Rendered " << imageWidth << "x" << imageHeight << " in " << columns << "x" << rows << " tiles of "
+              << tileWidth << "x" << tileHeight << " to " << options.renderOutput << " in " << seconds << " s"
+              << std::endl;
+    return 0;
+}
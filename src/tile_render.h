@@ -0,0 +1,17 @@
+#ifndef TILE_RENDER_H
+#define TILE_RENDER_H
+
+#include "options.h"
+
+#include <GLFW/glfw3.h>
+
+// Render one still of options.renderWidth x options.renderHeight from the start
+// of options.cameraPath into options.renderOutput (binary PPM). The image is
+// drawn in options.renderTile sized tiles with offset projections and read
+// back through a ring of pixel buffer objects, so the GPU draws the next tiles
+// while earlier ones are copied out. Only one row of tiles is held in memory
+// while a second one is written to disk on another thread. window only
+// provides the (hidden) GL context. Returns the process exit code.
+int runTileRender(const AppOptions& options, GLFWwindow* window);
+
+#endif
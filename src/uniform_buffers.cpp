@@ -0,0 +1,134 @@
+#include "uniform_buffers.h"
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <vector>
+
+// std140 MeshTransform block: vec4 origin, vec4 scale
+static const unsigned int MESH_TRANSFORM_BYTES = 8 * sizeof(float);
+static const unsigned int MESH_TRANSFORM_INITIAL_SLOTS = 256;
+
+static struct {
+    unsigned int buffer;
+    unsigned int stride; // record size rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    unsigned int capacity;
+    unsigned int used;
+    std::vector<unsigned int> freeSlots;
+} transforms;
+
+FrameUniforms createFrameUniforms() {
+    FrameUniforms uniforms = FrameUniforms();
+    glGenBuffers(1, &uniforms.buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, uniforms.buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformData), NULL, GL_STREAM_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, uniforms.buffer);
+    return uniforms;
+}
+
+glm::mat4 cameraProjection(float aspect, float farPlane) {
+    return glm::perspective(glm::radians(45.0f), aspect, 0.1f, farPlane);
+}
+
+glm::mat4 tileProjection(const glm::mat4& projection, int imageWidth, int imageHeight, int x, int y, int width,
+                         int height) {
+    // Scale the tile's NDC rectangle up to [-1, 1] around its center, applied after the projection
+    float scaleX = (float)imageWidth / width;
+    float scaleY = (float)imageHeight / height;
+    float centerX = (2.0f * x + width) / imageWidth - 1.0f;
+    float centerY = (2.0f * y + height) / imageHeight - 1.0f;
+    glm::mat4 tile(1.0f);
+    tile[0][0] = scaleX;
+    tile[1][1] = scaleY;
+    tile[3][0] = -centerX * scaleX;
+    tile[3][1] = -centerY * scaleY;
+    return tile * projection;
+}
+
+void updateFrameUniforms(FrameUniforms& uniforms, const glm::vec3& cameraPos, const glm::vec3& cameraFront,
+                         const glm::mat4& projection) {
+    FrameUniformData& data = uniforms.data;
+    data.view = glm::lookAt(cameraPos, cameraPos + cameraFront, glm::vec3(0.0f, 1.0f, 0.0f));
+    data.projection = projection;
+    data.viewProjection = data.projection * data.view;
+    data.cameraPos = glm::vec4(cameraPos, 1.0f);
+    uniforms.frustum = extractFrustum(data.viewProjection);
+    for (int i = 0; i < 6; i++)
+        data.frustumPlanes[i] = uniforms.frustum.planes[i];
+
+    // Orphan and refill, the previous frame's copy may still be in flight
+    glBindBuffer(GL_UNIFORM_BUFFER, uniforms.buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformData), &data, GL_STREAM_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, uniforms.buffer);
+}
+
+void destroyFrameUniforms(FrameUniforms& uniforms) {
+    glDeleteBuffers(1, &uniforms.buffer);
+    uniforms.buffer = 0;
+}
+
+void bindUniformBlocks(unsigned int program) {
+    unsigned int frameBlock = glGetUniformBlockIndex(program, "FrameUniforms");
+    if (frameBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, frameBlock, FRAME_UNIFORM_BINDING);
+    unsigned int transformBlock = glGetUniformBlockIndex(program, "MeshTransform");
+    if (transformBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, transformBlock, MESH_TRANSFORM_BINDING);
+}
+
+// Move the records into a buffer with room for capacity slots
+static void growMeshTransforms(unsigned int capacity) {
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, (size_t)capacity * transforms.stride, NULL, GL_STATIC_DRAW);
+    if (transforms.used) {
+        glBindBuffer(GL_COPY_READ_BUFFER, transforms.buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (size_t)transforms.used * transforms.stride);
+    }
+    glDeleteBuffers(1, &transforms.buffer);
+    transforms.buffer = buffer;
+    transforms.capacity = capacity;
+}
+
+unsigned int allocateMeshTransform(const glm::vec3& origin, const glm::vec3& scale) {
+    if (!transforms.stride) {
+        int alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment = std::max(alignment, 1);
+        transforms.stride = (MESH_TRANSFORM_BYTES + alignment - 1) / alignment * alignment;
+    }
+
+    unsigned int slot;
+    if (!transforms.freeSlots.empty()) {
+        slot = transforms.freeSlots.back();
+        transforms.freeSlots.pop_back();
+    } else {
+        if (transforms.used == transforms.capacity)
+            growMeshTransforms(std::max(MESH_TRANSFORM_INITIAL_SLOTS, transforms.capacity * 2));
+        slot = transforms.used++;
+    }
+
+    float record[8] = { origin.x, origin.y, origin.z, 0.0f, scale.x, scale.y, scale.z, 0.0f };
+    glBindBuffer(GL_UNIFORM_BUFFER, transforms.buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, (size_t)slot * transforms.stride, sizeof(record), record);
+    return slot;
+}
+
+void bindMeshTransform(unsigned int slot) {
+    glBindBufferRange(GL_UNIFORM_BUFFER, MESH_TRANSFORM_BINDING, transforms.buffer, (size_t)slot * transforms.stride,
+                      MESH_TRANSFORM_BYTES);
+}
+
+void releaseMeshTransform(unsigned int slot) {
+    transforms.freeSlots.push_back(slot);
+}
+
+void destroyMeshTransforms() {
+    glDeleteBuffers(1, &transforms.buffer);
+    transforms.buffer = 0;
+    transforms.capacity = 0;
+    transforms.used = 0;
+    transforms.freeSlots.clear();
+}
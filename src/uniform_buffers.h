@@ -0,0 +1,59 @@
+#ifndef UNIFORM_BUFFERS_H
+#define UNIFORM_BUFFERS_H
+
+#include "spatial_grid.h"
+
+#include <glm/glm.hpp>
+
+// Uniform block binding points, every program's blocks are pointed at them by bindUniformBlocks()
+static const unsigned int FRAME_UNIFORM_BINDING = 0;
+static const unsigned int MESH_TRANSFORM_BINDING = 1;
+
+// std140 mirror of the FrameUniforms block in shaders.cpp: everything that is
+// constant over a frame, uploaded once and read by every program
+struct FrameUniformData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 cameraPos; // w unused
+    glm::vec4 frustumPlanes[6];
+};
+
+struct FrameUniforms {
+    unsigned int buffer;
+    FrameUniformData data;
+    Frustum frustum; // the same planes, for culling on the CPU
+};
+
+FrameUniforms createFrameUniforms();
+
+// The perspective every view uses: 45 degree vertical field of view, near plane at 0.1
+glm::mat4 cameraProjection(float aspect, float farPlane);
+
+// Narrow projection to the pixels [x, x + width) x [y, y + height) (origin bottom
+// left) of an imageWidth x imageHeight frame, so a tile-sized viewport shows
+// exactly that part of the full image
+glm::mat4 tileProjection(const glm::mat4& projection, int imageWidth, int imageHeight, int x, int y, int width,
+                         int height);
+
+// Compute this frame's view matrix and frustum, upload them with the projection and
+// bind the block. The frustum follows the projection, so a tile culls to its own part.
+void updateFrameUniforms(FrameUniforms& uniforms, const glm::vec3& cameraPos, const glm::vec3& cameraFront,
+                         const glm::mat4& projection);
+
+void destroyFrameUniforms(FrameUniforms& uniforms);
+
+// Point the FrameUniforms and MeshTransform blocks of a program (those it declares) at their binding points
+void bindUniformBlocks(unsigned int program);
+
+// Per-mesh transforms (position = origin + vertex * scale) live in slots of one
+// shared uniform buffer, written when a mesh is created, so drawing a mesh
+// binds its slot instead of uploading uniforms. Needs a current GL context.
+unsigned int allocateMeshTransform(const glm::vec3& origin, const glm::vec3& scale);
+void bindMeshTransform(unsigned int slot);
+void releaseMeshTransform(unsigned int slot);
+
+// Delete the shared buffer once every mesh holding a slot is gone
+void destroyMeshTransforms();
+
+#endif
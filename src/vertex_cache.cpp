@@ -0,0 +1,161 @@
+#include "vertex_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Scoring parameters from Forsyth's "Linear-Speed Vertex Cache Optimisation"
+static const int FORSYTH_CACHE_SIZE = 32;
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount,
+                                    unsigned int cacheSize) {
+    VertexCacheStats stats = { 0.0, 0.0 };
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || cacheSize == 0)
+        return stats;
+
+    // Time each vertex entered the FIFO; it is still cached while fewer than cacheSize misses followed
+    std::vector<size_t> entered(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    size_t misses = 0;
+    size_t unique = 0;
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        unsigned int v = indices[i];
+        if (!referenced[v]) {
+            referenced[v] = true;
+            unique++;
+        }
+        if (entered[v] == 0 || misses - entered[v] >= cacheSize) {
+            misses++;
+            entered[v] = misses;
+        }
+    }
+
+    stats.acmr = (double)misses / triangleCount;
+    stats.atvr = (double)misses / unique;
+    return stats;
+}
+
+static float vertexScore(int cachePosition, unsigned int remaining) {
+    if (remaining == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        // The last triangle's three vertices score the same so its neighbours get no arbitrary edge
+        if (cachePosition < 3) {
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            float scale = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+        }
+    }
+
+    // Favour vertices with few triangles left so they don't linger as lone leftovers
+    return score + VALENCE_BOOST_SCALE * std::pow((float)remaining, -VALENCE_BOOST_POWER);
+}
+
+void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Triangles of every vertex, packed per vertex
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        remaining[indices[i]]++;
+    std::vector<size_t> adjacencyStart(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    std::vector<size_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        score[v] = vertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++)
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+    std::vector<unsigned int> source(indices, indices + triangleCount * 3);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    // Best triangle overall to start, afterwards only triangles touching the cache are candidates
+    size_t best = std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin();
+    size_t cursor = 0;
+    for (size_t out = 0; out < triangleCount; out++) {
+        if (best == triangleCount) {
+            // Nothing in the cache has triangles left, continue with the next unemitted one in input order
+            while (emitted[cursor])
+                cursor++;
+            best = cursor;
+        }
+
+        const unsigned int* triangle = &source[best * 3];
+        indices[out * 3] = triangle[0];
+        indices[out * 3 + 1] = triangle[1];
+        indices[out * 3 + 2] = triangle[2];
+        emitted[best] = true;
+
+        // Drop the triangle from its vertices' lists
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = triangle[k];
+            unsigned int* first = &adjacency[adjacencyStart[v]];
+            unsigned int* last = first + remaining[v];
+            *std::find(first, last, (unsigned int)best) = *(last - 1);
+            remaining[v]--;
+        }
+
+        // Its vertices move to the front of the LRU cache, the rest shift back
+        nextCache.assign(triangle, triangle + 3);
+        for (size_t i = 0; i < cache.size(); i++) {
+            unsigned int v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                nextCache.push_back(v);
+        }
+        for (size_t i = FORSYTH_CACHE_SIZE; i < nextCache.size(); i++)
+            cachePosition[nextCache[i]] = -1;
+        if (nextCache.size() > (size_t)FORSYTH_CACHE_SIZE)
+            nextCache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(nextCache);
+
+        // Rescore everything in or just evicted from the cache and pick the best triangle among their neighbours
+        for (size_t i = 0; i < cache.size(); i++)
+            cachePosition[cache[i]] = (int)i;
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            unsigned int v = nextCache[i];
+            score[v] = vertexScore(cachePosition[v], remaining[v]);
+        }
+        for (size_t i = 0; i < cache.size(); i++) {
+            unsigned int v = cache[i];
+            score[v] = vertexScore(cachePosition[v], remaining[v]);
+        }
+
+        best = triangleCount;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < cache.size(); i++) {
+            unsigned int v = cache[i];
+            for (unsigned int j = 0; j < remaining[v]; j++) {
+                unsigned int t = adjacency[adjacencyStart[v] + j];
+                const unsigned int* candidate = &source[t * 3];
+                triangleScore[t] = score[candidate[0]] + score[candidate[1]] + score[candidate[2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+    }
+}
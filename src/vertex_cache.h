@@ -0,0 +1,26 @@
+#ifndef VERTEX_CACHE_H
+#define VERTEX_CACHE_H
+
+#include <cstddef>
+
+// Post-transform cache behaviour of an indexed triangle list, simulated as a
+// FIFO of cacheSize vertices. acmr is vertices transformed per triangle (3
+// means no reuse at all), atvr is vertices transformed per vertex referenced
+// (1 means every vertex is shaded exactly once).
+struct VertexCacheStats {
+    double acmr;
+    double atvr;
+};
+
+// FIFO sizes the startup reports simulate: a small cache and a typical one
+static const unsigned int VERTEX_CACHE_REPORT_COUNT = 2;
+static const unsigned int VERTEX_CACHE_REPORT_SIZES[VERTEX_CACHE_REPORT_COUNT] = { 6, 16 };
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount,
+                                    unsigned int cacheSize);
+
+// Reorder triangles for the post-transform cache with Tom Forsyth's linear-speed
+// algorithm. Triangles keep their own vertex order, so winding is unchanged.
+void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+#endif
@@ -0,0 +1,409 @@
+#include "world.h"
+#include "geometry_builder.h"
+#include "job_queue.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+
+// Most chunks queued, running or waiting for upload at once; also the size of
+// the hand-back ring, so a finished build always finds a free cell
+static const size_t WORLD_MAX_PENDING = 64;
+
+// CPU half of a chunk, everything up to the GL calls. Built on any thread.
+struct ChunkBuild {
+    ChunkCoord coord;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    SpatialGrid grid;
+    std::vector<float> vertices;             // baked layout, packed meshes quantize on upload
+    std::vector<BuildingInstance> instances; // instanced layout
+    LodProxies proxies;
+    unsigned int levelCounts[LOD_LEVELS];    // arena chunks: buildings per level, baked back to back
+    size_t uploadBytes;                      // GPU bytes uploadChunk() will write
+};
+
+// Finished builds travel from the workers back to the render thread
+struct WorldJobs {
+    WorldJobs() : finished(WORLD_MAX_PENDING) {}
+    MpscQueue<ChunkBuild*> finished;
+};
+
+// Float and instanced chunks share the world's arena, packed ones carry their own quantization
+static bool sharesArena(const WorldSettings& settings) {
+    return settings.instanced || !settings.packedVertices;
+}
+
+static long long chunkKey(ChunkCoord coord) {
+    return ((long long)coord.x << 32) ^ (long long)(uint32_t)coord.z;
+}
+
+// Independent RNG stream per chunk coordinate
+static uint64_t chunkStream(unsigned int seed, ChunkCoord coord) {
+    return streamKey(seed, ((uint64_t)(uint32_t)coord.x << 32) | (uint32_t)coord.z);
+}
+
+static int chunkDistance(ChunkCoord a, ChunkCoord b) {
+    return std::max(std::abs(a.x - b.x), std::abs(a.z - b.z));
+}
+
+// Distance to the nearest of the camera chunks, every camera keeps its own neighbourhood resident
+static int chunkDistance(ChunkCoord coord, const std::vector<ChunkCoord>& centers) {
+    int nearest = chunkDistance(coord, centers[0]);
+    for (size_t i = 1; i < centers.size(); i++)
+        nearest = std::min(nearest, chunkDistance(coord, centers[i]));
+    return nearest;
+}
+
+static int squaredChunkDistance(ChunkCoord coord, const std::vector<ChunkCoord>& centers) {
+    int nearest = -1;
+    for (size_t i = 0; i < centers.size(); i++) {
+        int d = (coord.x - centers[i].x) * (coord.x - centers[i].x) + (coord.z - centers[i].z) * (coord.z - centers[i].z);
+        if (nearest < 0 || d < nearest)
+            nearest = d;
+    }
+    return nearest;
+}
+
+WorldSettings defaultWorldSettings() {
+    WorldSettings settings;
+    settings.chunkSize = 200.0f;
+    settings.buildingsPerChunk = 100;
+    settings.viewRadius = 5;
+    settings.maxResidentChunks = (2 * 6 + 1) * (2 * 6 + 1); // view radius plus one ring of hysteresis
+    settings.chunksPerFrame = 2;
+    settings.uploadBudgetBytes = 1024 * 1024;
+    settings.cellSize = 32.0f;
+    settings.seed = 0;
+    settings.instanced = false;
+    settings.packedVertices = false;
+    settings.lod = defaultLodSettings();
+    return settings;
+}
+
+StreamingWorld createWorld(const WorldSettings& settings, StreamBuffer* stream, ThreadPool* pool) {
+    StreamingWorld world;
+    world.settings = settings;
+    world.stream = stream;
+    world.pool = pool;
+    world.jobs = pool ? new WorldJobs() : nullptr;
+    world.arena = nullptr;
+    world.revision = 0;
+    return world;
+}
+
+void generateChunk(const WorldSettings& settings, ChunkCoord coord, std::vector<Building>& buildings) {
+    CounterRng rng(chunkStream(settings.seed, coord));
+
+    float minX = coord.x * settings.chunkSize;
+    float minZ = coord.z * settings.chunkSize;
+    size_t base = buildings.size();
+    buildings.resize(base + settings.buildingsPerChunk);
+    generateBuildings(rng, buildings.data() + base, settings.buildingsPerChunk, 0,
+                      minX, minX + settings.chunkSize, minZ, minZ + settings.chunkSize);
+
+    // Every chunk brings its own ground tile
+    buildings.push_back(createGround(minX + settings.chunkSize / 2.0f, minZ + settings.chunkSize / 2.0f,
+                                     settings.chunkSize, settings.chunkSize));
+}
+
+ChunkCoord chunkAt(const WorldSettings& settings, const glm::vec3& position) {
+    ChunkCoord coord;
+    coord.x = (int)std::floor(position.x / settings.chunkSize);
+    coord.z = (int)std::floor(position.z / settings.chunkSize);
+    return coord;
+}
+
+static void destroyChunk(StreamingWorld& world, WorldChunk& chunk) {
+    if (world.arena) {
+        releaseArenaSlots(*world.arena, chunk.firstSlot, chunk.slotCount);
+        return;
+    }
+    destroyLodGeometry(chunk.lod);
+    destroyBuildingMesh(chunk.buildingMesh);
+}
+
+// Generate, grid and bake one chunk without touching GL
+static void buildChunk(const WorldSettings& settings, ChunkCoord coord, ChunkBuild& build) {
+    std::vector<Building> buildings;
+    generateChunk(settings, coord, buildings);
+
+    build.coord = coord;
+    build.grid = buildSpatialGrid(buildings, settings.cellSize);
+
+    buildingBounds(buildings[0], build.boundsMin, build.boundsMax);
+    for (size_t i = 1; i < buildings.size(); i++) {
+        glm::vec3 bMin, bMax;
+        buildingBounds(buildings[i], bMin, bMax);
+        build.boundsMin = glm::min(build.boundsMin, bMin);
+        build.boundsMax = glm::max(build.boundsMax, bMax);
+    }
+
+    if (settings.lod.enabled)
+        buildLodProxies(build.grid, buildings, settings.lod.blockDivisions, build.proxies);
+
+    // Arena chunks bake their proxies right behind the full buildings into one run of slots
+    build.levelCounts[0] = buildings.size();
+    for (int level = 0; level < LOD_LEVELS - 1; level++) {
+        build.levelCounts[level + 1] = 0;
+        if (!sharesArena(settings))
+            continue;
+        std::vector<Building>& proxies = build.proxies.buildings[level];
+        build.levelCounts[level + 1] = proxies.size();
+        buildings.insert(buildings.end(), proxies.begin(), proxies.end());
+        proxies.clear();
+    }
+
+    size_t uploadCount = buildings.size();
+    for (int level = 0; level < LOD_LEVELS - 1; level++)
+        uploadCount += build.proxies.buildings[level].size();
+    if (settings.instanced) {
+        build.instances.resize(buildings.size());
+        bakeBuildingInstances(buildings.data(), buildings.size(), build.instances.data(), nullptr);
+    } else {
+        GeometryBuilder builder;
+        build.vertices.resize(buildings.size() * 48);
+        bakeBuildingVertices(builder, buildings.data(), buildings.size(), false, glm::vec3(0.0f), glm::vec3(1.0f),
+                             build.vertices.data(), nullptr);
+    }
+
+    GeometrySizes sizes = buildingGeometrySizes(uploadCount, settings.packedVertices);
+    build.uploadBytes = settings.instanced ? sizes.instanceBytes : sizes.vertexBytes;
+}
+
+// GL half of a chunk, render thread only.
+// The CPU copy is dropped here, revisiting the tile regenerates it from the seed.
+static void uploadChunk(StreamingWorld& world, ChunkBuild& build) {
+    const WorldSettings& settings = world.settings;
+
+    WorldChunk chunk = WorldChunk();
+    chunk.coord = build.coord;
+    chunk.boundsMin = build.boundsMin;
+    chunk.boundsMax = build.boundsMax;
+    chunk.grid = std::move(build.grid);
+
+    if (sharesArena(settings)) {
+        unsigned int count = settings.instanced ? build.instances.size() : build.vertices.size() / 48;
+        if (!world.arena) {
+            // Room for a full view of chunks like the first before the arena has to grow
+            world.arena = new ChunkArena(createChunkArena(settings.instanced, count * settings.maxResidentChunks));
+        }
+        chunk.firstSlot = allocateArenaSlots(*world.arena, count);
+        chunk.slotCount = count;
+        if (settings.instanced)
+            writeArenaInstances(*world.arena, world.stream, chunk.firstSlot, build.instances.data(), count);
+        else
+            writeArenaVertices(*world.arena, world.stream, chunk.firstSlot, build.vertices.data(), count);
+
+        unsigned int first = chunk.firstSlot;
+        for (int level = 0; level < LOD_LEVELS; level++) {
+            chunk.levelFirst[level] = first;
+            first += build.levelCounts[level];
+        }
+        for (int level = 0; level < LOD_LEVELS - 1; level++)
+            chunk.lod.cellRanges[level].swap(build.proxies.ranges[level]);
+        chunk.lod.instanced = settings.instanced;
+    } else {
+        chunk.buildingMesh = createBuildingMesh(build.vertices.data(), build.vertices.size(),
+                                                settings.packedVertices, world.stream);
+        if (settings.lod.enabled)
+            chunk.lod = createLodGeometry(build.proxies, false, settings.packedVertices, world.stream);
+    }
+
+    world.chunks[chunkKey(chunk.coord)] = chunk;
+    world.revision++;
+}
+
+// At the residency cap, evict the furthest chunk if it is further than coord.
+// False when there is no room for coord.
+static bool makeRoom(StreamingWorld& world, ChunkCoord coord, const std::vector<ChunkCoord>& centers) {
+    if ((int)world.chunks.size() < world.settings.maxResidentChunks)
+        return true;
+
+    std::unordered_map<long long, WorldChunk>::iterator furthest = world.chunks.end();
+    int furthestDistance = -1;
+    for (std::unordered_map<long long, WorldChunk>::iterator it = world.chunks.begin(); it != world.chunks.end(); ++it) {
+        int d = chunkDistance(it->second.coord, centers);
+        if (d > furthestDistance) {
+            furthestDistance = d;
+            furthest = it;
+        }
+    }
+    if (furthest == world.chunks.end() || furthestDistance <= chunkDistance(coord, centers))
+        return false;
+    destroyChunk(world, furthest->second);
+    world.chunks.erase(furthest);
+    world.revision++;
+    return true;
+}
+
+// Upload finished background builds nearest first until the byte budget is spent.
+// The first one always goes through so a single large chunk can't stall streaming.
+static void uploadReadyChunks(StreamingWorld& world, const std::vector<ChunkCoord>& centers) {
+    ChunkBuild* build;
+    while (world.jobs->finished.pop(build))
+        world.ready.push_back(build);
+
+    std::sort(world.ready.begin(), world.ready.end(), [&centers](const ChunkBuild* a, const ChunkBuild* b) {
+        return chunkDistance(a->coord, centers) < chunkDistance(b->coord, centers);
+    });
+
+    std::vector<ChunkBuild*> waiting;
+    size_t uploaded = 0;
+    for (size_t i = 0; i < world.ready.size(); i++) {
+        build = world.ready[i];
+        bool outOfRange = chunkDistance(build->coord, centers) > world.settings.viewRadius + 1;
+        bool inBudget = uploaded == 0 || uploaded + build->uploadBytes <= world.settings.uploadBudgetBytes;
+        if (!outOfRange && !(inBudget && makeRoom(world, build->coord, centers))) {
+            waiting.push_back(build);
+            continue;
+        }
+
+        // Uploaded, or the camera moved on while it was being built
+        if (!outOfRange) {
+            uploadChunk(world, *build);
+            uploaded += build->uploadBytes;
+        }
+        world.pending.erase(chunkKey(build->coord));
+        delete build;
+    }
+    world.ready.swap(waiting);
+}
+
+void updateWorld(StreamingWorld& world, const glm::vec3& cameraPos) {
+    updateWorld(world, std::vector<glm::vec3>(1, cameraPos));
+}
+
+void updateWorld(StreamingWorld& world, const std::vector<glm::vec3>& cameraPositions) {
+    const WorldSettings& settings = world.settings;
+    if (cameraPositions.empty())
+        return;
+    std::vector<ChunkCoord> centers(cameraPositions.size());
+    for (size_t i = 0; i < cameraPositions.size(); i++)
+        centers[i] = chunkAt(settings, cameraPositions[i]);
+
+    // Evict chunks beyond the view radius plus one ring, so crossing a border doesn't thrash
+    for (std::unordered_map<long long, WorldChunk>::iterator it = world.chunks.begin(); it != world.chunks.end();) {
+        if (chunkDistance(it->second.coord, centers) > settings.viewRadius + 1) {
+            destroyChunk(world, it->second);
+            it = world.chunks.erase(it);
+            world.revision++;
+        } else {
+            ++it;
+        }
+    }
+
+    if (world.pool)
+        uploadReadyChunks(world, centers);
+
+    // Missing chunks inside the view radius of any camera, nearest first
+    std::vector<ChunkCoord> missing;
+    std::unordered_set<long long> listed;
+    for (size_t c = 0; c < centers.size(); c++) {
+        for (int dz = -settings.viewRadius; dz <= settings.viewRadius; dz++) {
+            for (int dx = -settings.viewRadius; dx <= settings.viewRadius; dx++) {
+                ChunkCoord coord;
+                coord.x = centers[c].x + dx;
+                coord.z = centers[c].z + dz;
+                long long key = chunkKey(coord);
+                if (world.chunks.find(key) == world.chunks.end() && world.pending.find(key) == world.pending.end()
+                    && listed.insert(key).second)
+                    missing.push_back(coord);
+            }
+        }
+    }
+    std::sort(missing.begin(), missing.end(), [&centers](ChunkCoord a, ChunkCoord b) {
+        return squaredChunkDistance(a, centers) < squaredChunkDistance(b, centers);
+    });
+
+    int budget = settings.chunksPerFrame;
+    for (size_t i = 0; i < missing.size() && budget > 0; i++, budget--) {
+        if (!world.pool) {
+            if (!makeRoom(world, missing[i], centers))
+                break;
+            ChunkBuild build;
+            buildChunk(settings, missing[i], build);
+            uploadChunk(world, build);
+            continue;
+        }
+
+        // Hand the CPU work to a worker, the result comes back through the ring
+        if (world.pending.size() >= WORLD_MAX_PENDING)
+            break;
+        world.pending.insert(chunkKey(missing[i]));
+        WorldJobs* jobs = world.jobs;
+        WorldSettings jobSettings = settings;
+        ChunkCoord coord = missing[i];
+        world.pool->submit([jobs, jobSettings, coord] {
+            ChunkBuild* build = new ChunkBuild();
+            buildChunk(jobSettings, coord, *build);
+            jobs->finished.push(build);
+        });
+    }
+}
+
+bool worldStreaming(const StreamingWorld& world) {
+    return !world.pending.empty() || !world.ready.empty();
+}
+
+void queueWorld(StreamingWorld& world, const Frustum& frustum, const glm::vec3& cameraPos, unsigned int program,
+                RenderQueue& queue) {
+    for (std::unordered_map<long long, WorldChunk>::iterator it = world.chunks.begin(); it != world.chunks.end(); ++it) {
+        const WorldChunk& chunk = it->second;
+        if (!boxInFrustum(frustum, chunk.boundsMin, chunk.boundsMax))
+            continue;
+        float distance = glm::length(cameraPos - glm::clamp(cameraPos, chunk.boundsMin, chunk.boundsMax));
+
+        std::vector<DrawRange>& fullRanges = world.settings.lod.enabled ? world.lodRanges[0] : world.visibleRanges;
+        if (world.settings.lod.enabled)
+            selectLod(chunk.grid, chunk.lod, world.settings.lod, frustum, cameraPos, world.lodRanges);
+        else
+            cullSpatialGrid(chunk.grid, frustum, world.visibleRanges);
+
+        if (world.arena) {
+            int levels = world.settings.lod.enabled ? LOD_LEVELS : 1;
+            for (int level = 0; level < levels; level++)
+                queueArenaRanges(queue, program, level, distance, *world.arena, chunk.levelFirst[level],
+                                 level ? world.lodRanges[level] : fullRanges);
+            continue;
+        }
+        queueBuildingMesh(queue, program, 0, distance, chunk.buildingMesh, fullRanges, 0);
+        if (world.settings.lod.enabled)
+            queueLodProxies(queue, program, distance, chunk.lod, world.lodRanges);
+    }
+}
+
+void destroyWorld(StreamingWorld& world) {
+    if (world.jobs) {
+        // Workers still hold a pointer to the ring, collect every build they owe us
+        size_t running = world.pending.size() - world.ready.size();
+        while (running) {
+            ChunkBuild* build;
+            if (world.jobs->finished.pop(build)) {
+                delete build;
+                running--;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        for (size_t i = 0; i < world.ready.size(); i++)
+            delete world.ready[i];
+        world.ready.clear();
+        world.pending.clear();
+        delete world.jobs;
+        world.jobs = nullptr;
+    }
+
+    for (std::unordered_map<long long, WorldChunk>::iterator it = world.chunks.begin(); it != world.chunks.end(); ++it)
+        destroyChunk(world, it->second);
+    world.chunks.clear();
+    if (world.arena) {
+        destroyChunkArena(*world.arena);
+        delete world.arena;
+        world.arena = nullptr;
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "building_mesh.h"
+#include "chunk_arena.h"
+#include "city.h"
+#include "instancing.h"
+#include "lod.h"
+#include "render_queue.h"
+#include "spatial_grid.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class ThreadPool;
+struct ChunkBuild;
+struct WorldJobs;
+
+// Integer tile coordinate on the XZ plane
+struct ChunkCoord {
+    int x;
+    int z;
+};
+
+// Tiled world configuration
+struct WorldSettings {
+    float chunkSize;         // world units per chunk edge
+    int buildingsPerChunk;
+    int viewRadius;          // chunks loaded in each direction around the camera chunk
+    int maxResidentChunks;   // hard cap on chunks holding GPU data
+    int chunksPerFrame;      // generation budget per updateWorld() call
+    size_t uploadBudgetBytes; // GPU bytes of finished background chunks uploaded per updateWorld() call
+    float cellSize;          // spatial grid cell size inside a chunk
+    unsigned int seed;
+    bool instanced;
+    bool packedVertices;
+    LodSettings lod;
+};
+
+// A resident chunk, only GPU buffers and culling bounds are kept. Float and
+// instanced chunks live in the world's ChunkArena, full detail and proxies in
+// one run of slots; packed chunks quantize into their own bounds, which a
+// shared buffer can't express, and keep their own meshes.
+struct WorldChunk {
+    ChunkCoord coord;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    SpatialGrid grid;
+    BuildingMesh buildingMesh;           // packed chunks only
+    LodGeometry lod;                     // arena chunks only use its cell ranges
+    unsigned int firstSlot;              // arena run: full buildings, then each proxy level
+    unsigned int slotCount;
+    unsigned int levelFirst[LOD_LEVELS]; // slot of each level's first building
+};
+
+// Chunks streamed in and out around the camera
+struct StreamingWorld {
+    WorldSettings settings;
+    std::unordered_map<long long, WorldChunk> chunks;
+    std::vector<DrawRange> visibleRanges;
+    std::vector<DrawRange> lodRanges[LOD_LEVELS];
+    StreamBuffer* stream; // staging ring for chunk uploads, null uploads directly
+    ChunkArena* arena;    // shared chunk buffers, created with the first chunk, null for packed chunks
+
+    // Background generation, pool is null when chunks are built on the render thread
+    ThreadPool* pool;
+    WorldJobs* jobs;                         // finished builds coming back from the workers
+    std::unordered_set<long long> pending;   // chunks queued or running on a worker
+    std::vector<ChunkBuild*> ready;          // finished builds waiting for upload budget
+    unsigned int revision;                   // bumped whenever a chunk is uploaded or evicted
+};
+
+// Default settings sized so the view radius covers the 1000 unit far plane
+WorldSettings defaultWorldSettings();
+
+// With a pool, chunks are generated, gridded and baked on its workers and only
+// uploaded on the calling (GL) thread, within settings.uploadBudgetBytes per frame.
+// Without one every chunk is built and uploaded inside updateWorld().
+StreamingWorld createWorld(const WorldSettings& settings, StreamBuffer* stream, ThreadPool* pool);
+
+// Deterministically generate the buildings (and ground tile) of one chunk.
+// The same seed and coordinate always reproduce the same buildings.
+void generateChunk(const WorldSettings& settings, ChunkCoord coord, std::vector<Building>& buildings);
+
+// Chunk containing a world position
+ChunkCoord chunkAt(const WorldSettings& settings, const glm::vec3& position);
+
+// Evict chunks outside the view radius, queue (or build) missing ones nearest
+// first and upload background builds that have finished
+void updateWorld(StreamingWorld& world, const glm::vec3& cameraPos);
+
+// Same for several cameras sharing the world: a chunk stays resident while it
+// is near any of them and missing chunks are ordered by their nearest camera
+void updateWorld(StreamingWorld& world, const std::vector<glm::vec3>& cameraPositions);
+
+// Frustum cull chunks, then the grid cells inside each visible chunk, and queue
+// each cell at the level of detail its distance from the camera calls for.
+// Arena chunks all queue against the same mesh, so the sorted queue merges them
+// into one draw per level of detail. The queue points at chunk meshes, submit
+// it before the next updateWorld().
+void queueWorld(StreamingWorld& world, const Frustum& frustum, const glm::vec3& cameraPos, unsigned int program,
+                RenderQueue& queue);
+
+// True while chunks are queued on the workers or waiting for upload budget
+bool worldStreaming(const StreamingWorld& world);
+
+// Waits for chunks still running on the workers before releasing everything
+void destroyWorld(StreamingWorld& world);
+
+#endif